@@ -6,18 +6,25 @@
 
 #include "stdafx.h"
 #include "PatchMatchStereo.h"
+#include <cstring>
 #include <ctime>
 #include <random>
+#include <thread>
 #include "pms_propagation.h"
 #include "pms_util.h"
 
+/** \brief ڴӳ洢ʱÿԤȡĵͼдֽƽ漰ۺϼƣ */
+constexpr size_t Prefetch_Band_Bytes = 4 << 20;
+
 PatchMatchStereo::PatchMatchStereo(): width_(0), height_(0), img_left_(nullptr), img_right_(nullptr),
                                       gray_left_(nullptr), gray_right_(nullptr),
                                       grad_left_(nullptr), grad_right_(nullptr),
                                       cost_left_(nullptr), cost_right_(nullptr), 
                                       disp_left_(nullptr), disp_right_(nullptr),
                                       plane_left_(nullptr), plane_right_(nullptr),
-                                      is_initialized_(false) { }
+                                      coarse_level_(nullptr), img_coarse_left_(nullptr), img_coarse_right_(nullptr),
+                                      seed_(0), has_prev_frame_(false), is_warm_frame_(false), num_warm_frames_(0),
+                                      motion_x_(nullptr), motion_y_(nullptr), is_initialized_(false) { }
 
 
 PatchMatchStereo::~PatchMatchStereo()
@@ -48,31 +55,145 @@ bool PatchMatchStereo::Initialize(const sint32 & width, const sint32 & height, c
 	// ݶ
 	grad_left_ = new PGradient[img_size]();
 	grad_right_ = new PGradient[img_size]();
+	// ͨݣչ߽粻Сڰ봰
+	const bool is_planar_created = CreatePlanarImages(option);
 	// 
-	cost_left_ = new float32[img_size];
-	cost_right_ = new float32[img_size];
+	const bool is_mapped = option.is_mapped_storage;
+	storage_cost_left_.Allocate(img_size * sizeof(float32), is_mapped, option.storage_dir);
+	storage_cost_right_.Allocate(img_size * sizeof(float32), is_mapped, option.storage_dir);
+	cost_left_ = storage_cost_left_.data<float32>();
+	cost_right_ = storage_cost_right_.data<float32>();
 	// Ӳͼ
 	disp_left_ = new float32[img_size];
 	disp_right_ = new float32[img_size];
 	// ƽ漯
-	plane_left_ = new DisparityPlane[img_size];
-	plane_right_ = new DisparityPlane[img_size];
-
-	is_initialized_ = grad_left_ && grad_right_ && disp_left_ && disp_right_  && plane_left_ && plane_right_;
+	storage_plane_left_.Allocate(img_size * sizeof(DisparityPlane), is_mapped, option.storage_dir);
+	storage_plane_right_.Allocate(img_size * sizeof(DisparityPlane), is_mapped, option.storage_dir);
+	plane_left_ = storage_plane_left_.data<DisparityPlane>();
+	plane_right_ = storage_plane_right_.data<DisparityPlane>();
+
+	is_initialized_ = is_planar_created && grad_left_ && grad_right_ && disp_left_ && disp_right_  && plane_left_ && plane_right_ && cost_left_ && cost_right_;
+
+	// һ
+	sint32 width_coarse, height_coarse;
+	PMSOption option_coarse;
+	if (is_initialized_ && GetCoarseLevel(width, height, option, width_coarse, height_coarse, option_coarse)) {
+		img_coarse_left_ = new uint8[width_coarse * height_coarse * 3];
+		img_coarse_right_ = new uint8[width_coarse * height_coarse * 3];
+		coarse_level_ = new PatchMatchStereo;
+		is_initialized_ = coarse_level_->Initialize(width_coarse, height_coarse, option_coarse);
+	}
 
 	return is_initialized_;
 }
 
+bool PatchMatchStereo::GetCoarseLevel(const sint32& width, const sint32& height, const PMSOption& option,
+	sint32& width_coarse, sint32& height_coarse, PMSOption& option_coarse)
+{
+	// Ӱߴ룬ӲΧڳߴ֮СֲӰСʱٷֲ
+	width_coarse = (width + 1) / 2;
+	height_coarse = (height + 1) / 2;
+	const sint32 patch_coarse = std::max(5, (option.patch_size / 2) | 1);
+	if (option.pyramid_levels <= 1 || std::min(width_coarse, height_coarse) < 2 * patch_coarse) {
+		return false;
+	}
+	option_coarse = option;
+	option_coarse.pyramid_levels = option.pyramid_levels - 1;
+	option_coarse.patch_size = patch_coarse;
+	option_coarse.min_disparity = static_cast<sint32>(floor(option.min_disparity / 2.0));
+	option_coarse.max_disparity = static_cast<sint32>(ceil(option.max_disparity / 2.0));
+	// ֲֻṩƽֵ
+	option_coarse.is_check_lr = false;
+	option_coarse.is_fill_holes = false;
+	option_coarse.is_temporal = false;
+	return true;
+}
+
+bool PatchMatchStereo::CreatePlanarImages(const PMSOption& option)
+{
+	const sint32 pad = option.patch_size / 2;
+	if (!planar_left_.Create(width_, height_, pad, option.is_fixed_point) ||
+		!planar_right_.Create(width_, height_, pad, option.is_fixed_point)) {
+		return false;
+	}
+	// ƽֻ踲ͬĶȡΧչ߽ȡСֵ
+	if (option.subpixel_factor > 1 && !option.is_fixed_point) {
+		return planar_left_sub_.Create(width_, height_, 0, false, option.subpixel_factor) &&
+			planar_right_sub_.Create(width_, height_, 0, false, option.subpixel_factor);
+	}
+	planar_left_sub_.Release();
+	planar_right_sub_.Release();
+	return true;
+}
+
+sint64 PatchMatchStereo::EstimateMemory(const sint32& width, const sint32& height, const PMSOption& option)
+{
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+	// ÿͼҶȡݶȡۡӲƽ漰ͨݣչ߽磩ۼƽλڴӳļʱ
+	const sint64 img_size = static_cast<sint64>(width) * height;
+	const sint64 pad = std::max((option.patch_size / 2 + 15) / 16 * 16, 16);
+	const sint64 planar_elem = option.is_fixed_point ? sizeof(sint16) : sizeof(float32);
+	const sint64 planar_size = (width + 2 * pad + 15) / 16 * 16 * (height + 2 * pad) * PlanarImage::NUM_CHANNELS * planar_elem;
+	sint64 per_pixel = sizeof(uint8) + sizeof(PGradient) + sizeof(float32);
+	if (!option.is_mapped_storage) {
+		per_pixel += sizeof(float32) + sizeof(DisparityPlane);
+	}
+	sint64 bytes = 2 * (img_size * per_pixel + planar_size);
+	if (option.subpixel_factor > 1 && !option.is_fixed_point) {
+		const sint64 sub_stride = ((width + 32) * option.subpixel_factor + 15) / 16 * 16;
+		bytes += 2 * sub_stride * (height + 32) * PlanarImage::NUM_CHANNELS * sizeof(float32);
+	}
+
+	// ͼЧؼȫЧ㣬ʱֵ˲Ϊһfloat32
+	if (option.is_check_lr) {
+		bytes += 2 * img_size * sizeof(pair<int, int>);
+		if (option.is_fill_holes) {
+			bytes += img_size * sizeof(float32);
+			if (option.median_filter == PMS_MEDIAN_CONSTANT_TIME) {
+				bytes += img_size * sizeof(float32);
+			}
+			// ֱͼȨֵصı뼰̵ֱ߳ͼ
+			if (option.median_filter == PMS_MEDIAN_WEIGHTED_HIST) {
+				bytes += img_size * sizeof(uint32) +
+					pms_util::GetNumThreads(option.num_threads) * pms_util::JointHistogram::EstimateMemory(option.patch_size);
+			}
+		}
+	}
+
+	// һ㣺ֲӰ񼰴ֲʵ
+	sint32 width_coarse, height_coarse;
+	PMSOption option_coarse;
+	if (GetCoarseLevel(width, height, option, width_coarse, height_coarse, option_coarse)) {
+		bytes += 2 * static_cast<sint64>(width_coarse) * height_coarse * 3;
+		bytes += EstimateMemory(width_coarse, height_coarse, option_coarse);
+	}
+	return bytes;
+}
+
 void PatchMatchStereo::Release()
 {
 	SAFE_DELETE(grad_left_);
 	SAFE_DELETE(grad_right_);
-	SAFE_DELETE(cost_left_);
-	SAFE_DELETE(cost_right_);
+	planar_left_.Release();
+	planar_right_.Release();
+	planar_left_sub_.Release();
+	planar_right_sub_.Release();
+	storage_cost_left_.Release();
+	storage_cost_right_.Release();
+	cost_left_ = cost_right_ = nullptr;
 	SAFE_DELETE(disp_left_);
 	SAFE_DELETE(disp_right_);
-	SAFE_DELETE(plane_left_);
-	SAFE_DELETE(plane_right_);
+	storage_plane_left_.Release();
+	storage_plane_right_.Release();
+	plane_left_ = plane_right_ = nullptr;
+	SAFE_DELETE(img_coarse_left_);
+	SAFE_DELETE(img_coarse_right_);
+	if (coarse_level_) {
+		delete coarse_level_;
+		coarse_level_ = nullptr;
+	}
 }
 
 bool PatchMatchStereo::Match(const uint8* img_left, const uint8* img_right, float32* disp_left)
@@ -87,41 +208,125 @@ bool PatchMatchStereo::Match(const uint8* img_left, const uint8* img_right, floa
 	img_left_ = img_left;
 	img_right_ = img_right;
 
-	// ʼ
-	RandomInitialization();
+	// ׶μʱ
+	stats_ = PMSStatistics();
+	const pms_util::Timer timer_total;
+	pms_util::Timer timer;
+
+	// ӣδָʱÿƥ
+	seed_ = option_.seed;
+	if (seed_ == 0) {
+		std::random_device rd;
+		seed_ = rd();
+	}
+
+	is_warm_frame_ = option_.is_temporal && has_prev_frame_;
+	if (is_warm_frame_) {
+		// Ƶģʽһ֡ӲƽΪֵ
+		TemporalInitialization();
+	}
+	else if (coarse_level_) {
+		// ģʽƥһ㣬ϲӲƽΪֵ
+		pms_util::DownsampleImage(img_left_, width_, height_, img_coarse_left_);
+		pms_util::DownsampleImage(img_right_, width_, height_, img_coarse_right_);
+		if (!coarse_level_->Match(img_coarse_left_, img_coarse_right_, nullptr)) {
+			return false;
+		}
+		PyramidInitialization();
+	}
+	else {
+		// ʼ
+		RandomInitialization();
+	}
+	stats_.time_init = timer.Restart();
 
 	// Ҷͼ
 	ComputeGray();
+	stats_.time_gray = timer.Restart();
 
 	// ݶͼ
 	ComputeGradient();
+	stats_.time_gradient = timer.Restart();
+
+	// ɷͨ
+	const sint32 num_threads = pms_util::GetNumThreads(option_.num_threads);
+	planar_left_.Fill(img_left_, grad_left_, num_threads);
+	planar_right_.Fill(img_right_, grad_right_, num_threads);
+	planar_left_sub_.Fill(img_left_, grad_left_, num_threads);
+	planar_right_sub_.Fill(img_right_, grad_right_, num_threads);
+	stats_.time_planar = timer.Restart();
 
-	// 
+	// ʱڴм¼
 	Propagation();
+	timer.Restart();
+
+	// ׶ζִ߳Уڶƥ֮临
+	post_.Prepare(width_, height_, option_);
 
 	// ƽתӲ
 	PlaneToDisparity();
+	stats_.time_plane_to_disp = timer.Restart();
 
 	// һԼ
 	if (option_.is_check_lr) {
 		// һԼ
 		LRCheck();
+		stats_.time_lr_check = timer.Restart();
 	}
 
 	// Ӳ
 	if (option_.is_fill_holes) {
 		FillHolesInDispMap();
+		stats_.time_fill_holes = timer.Restart();
 	}
 
 	// Ӳͼ
 	if (disp_left && disp_left_) {
 		memcpy(disp_left, disp_left_, height_ * width_ * sizeof(float32));
 	}
+
+	// Ƶģʽ֡ƽ湩һ֡ʹã˶ֻԱ֡Ч
+	has_prev_frame_ = option_.is_temporal;
+	motion_x_ = motion_y_ = nullptr;
+	stats_.time_total = timer_total.Elapsed();
 	return true;
 }
 
+void PatchMatchStereo::SetFrameMotion(const float32* motion_x, const float32* motion_y)
+{
+	motion_x_ = motion_x;
+	motion_y_ = motion_y;
+	if (motion_x_ == nullptr || motion_y_ == nullptr) {
+		motion_x_ = motion_y_ = nullptr;
+	}
+}
+
+void PatchMatchStereo::ClearTemporalState()
+{
+	has_prev_frame_ = false;
+	num_warm_frames_ = 0;
+	motion_x_ = motion_y_ = nullptr;
+}
+
 bool PatchMatchStereo::Reset(const uint32& width, const uint32& height, const PMSOption& option)
 {
+	ClearTemporalState();
+
+	// ߴ缰ڴ沼ֲʱֻ²ѷڴ
+	sint32 width_coarse, height_coarse;
+	PMSOption option_coarse;
+	if (is_initialized_ && static_cast<sint32>(width) == width_ && static_cast<sint32>(height) == height_ &&
+		option.is_mapped_storage == option_.is_mapped_storage && option.storage_dir == option_.storage_dir &&
+		GetCoarseLevel(width_, height_, option, width_coarse, height_coarse, option_coarse) == (coarse_level_ != nullptr)) {
+		option_ = option;
+		// ͨݵչ߽洰ڳߴ仯ߴͬʱ·
+		is_initialized_ = CreatePlanarImages(option);
+		if (is_initialized_ && coarse_level_) {
+			is_initialized_ = coarse_level_->Reset(width_coarse, height_coarse, option_coarse);
+		}
+		return is_initialized_;
+	}
+
 	// ͷڴ
 	Release();
 	
@@ -143,6 +348,11 @@ float* PatchMatchStereo::GetDisparityMap(const sint32& view) const
 	}
 }
 
+const PMSStatistics& PatchMatchStereo::GetStatistics() const
+{
+	return stats_;
+}
+
 PGradient* PatchMatchStereo::GetGradientMap(const sint32& view) const
 {
 	switch (view) {
@@ -165,49 +375,121 @@ void PatchMatchStereo::RandomInitialization() const
 		return;
 	}
 	const auto& option = option_;
-	const sint32 min_disparity = option.min_disparity;
-	const sint32 max_disparity = option.max_disparity;
-
-	// 
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	const std::uniform_real_distribution<float32> rand_d(static_cast<float32>(min_disparity), static_cast<float32>(max_disparity));
-	const std::uniform_real_distribution<float32> rand_n(-1.0f, 1.0f);
 
 	for (int k = 0; k < 2; k++) {
 		auto* disp_ptr = k == 0 ? disp_left_ : disp_right_;
 		auto* plane_ptr = k == 0 ? plane_left_ : plane_right_;
 		sint32 sign = (k == 0) ? 1:-1;
-		for (sint32 y = 0; y < height; y++) {
+		// ͼΪпɲ
+		pms_util::ParallelFor(0, height, pms_util::GetNumThreads(option.num_threads), [&](const sint32& y, const sint32&) {
 			for (sint32 x = 0; x < width; x++) {
 				const sint32 p = y * width + x;
-				// Ӳֵ
-				float32 disp = sign * rand_d(gen);
-				if (option.is_integer_disp) {
-					disp = static_cast<float32>(round(disp));
+				PMSRandom rng(seed_, k, p);
+				RandomPlane(rng, x, y, sign, disp_ptr[p], plane_ptr[p]);
+			}
+		});
+	}
+}
+
+void PatchMatchStereo::RandomPlane(PMSRandom& rng, const sint32& x, const sint32& y, const sint32& sign, float32& disp, DisparityPlane& plane) const
+{
+	const auto& option = option_;
+
+	// Ӳֵ
+	disp = sign * rng.Uniform(static_cast<float32>(option.min_disparity), static_cast<float32>(option.max_disparity));
+	if (option.is_integer_disp) {
+		disp = static_cast<float32>(round(disp));
+	}
+
+	// 
+	PVector3f norm;
+	if (!option.is_fource_fpw) {
+		norm.x = rng.Uniform(-1.0f, 1.0f);
+		norm.y = rng.Uniform(-1.0f, 1.0f);
+		float32 z = rng.Uniform(-1.0f, 1.0f);
+		while (z == 0.0f) {
+			z = rng.Uniform(-1.0f, 1.0f);
+		}
+		norm.z = z;
+		norm.normalize();
+	}
+	else {
+		norm.x = 0.0f; norm.y = 0.0f; norm.z = 1.0f;
+	}
+
+	// Ӳƽ
+	plane = DisparityPlane(x, y, norm, disp);
+}
+
+void PatchMatchStereo::TemporalInitialization()
+{
+	const sint32 width = width_;
+	const sint32 height = height_;
+	if (width <= 0 || height <= 0 ||
+		disp_left_ == nullptr || disp_right_ == nullptr ||
+		plane_left_ == nullptr || plane_right_ == nullptr) {
+		return;
+	}
+	const sint32 num_threads = pms_util::GetNumThreads(option_.num_threads);
+	const float32 ratio = option_.temporal_rerandom_ratio;
+	// ֡ʹòͬ֡仯
+	const uint64 stream = 2 + 2 * static_cast<uint64>(num_warm_frames_++);
+
+	for (int k = 0; k < 2; k++) {
+		auto* disp_ptr = k == 0 ? disp_left_ : disp_right_;
+		auto* plane_ptr = k == 0 ? plane_left_ : plane_right_;
+		const sint32 sign = (k == 0) ? 1 : -1;
+
+		// ˶ǰ֡ȡһ֡Ӧλõƽ棨ڣƽ
+		if (motion_x_ && motion_y_) {
+			warp_planes_.assign(plane_ptr, plane_ptr + width * height);
+			pms_util::ParallelFor(0, height, num_threads, [&](const sint32& y, const sint32&) {
+				for (sint32 x = 0; x < width; x++) {
+					const sint32 p = y * width + x;
+					const float32 dx = motion_x_[p], dy = motion_y_[p];
+					const sint32 xs = std::min(std::max(static_cast<sint32>(lround(x - dx)), 0), width - 1);
+					const sint32 ys = std::min(std::max(static_cast<sint32>(lround(y - dy)), 0), height - 1);
+					plane_ptr[p] = warp_planes_[ys * width + xs].to_translated(dx, dy);
 				}
-				disp_ptr[p] = disp;
-
-				// 
-				PVector3f norm;
-				if (!option.is_fource_fpw) {
-					norm.x = rand_n(gen);
-					norm.y = rand_n(gen);
-					float32 z = rand_n(gen);
-					while (z == 0.0f) {
-						z = rand_n(gen);
+			});
+		}
+
+		// ʼ
+		if (ratio > 0.0f) {
+			pms_util::ParallelFor(0, height, num_threads, [&](const sint32& y, const sint32&) {
+				for (sint32 x = 0; x < width; x++) {
+					const sint32 p = y * width + x;
+					PMSRandom rng(seed_, stream + k, p);
+					if (rng.Uniform() < ratio) {
+						RandomPlane(rng, x, y, sign, disp_ptr[p], plane_ptr[p]);
 					}
-					norm.z = z;
-					norm.normalize();
-				}
-				else {
-					norm.x = 0.0f; norm.y = 0.0f; norm.z = 1.0f;
 				}
+			});
+		}
+	}
+}
 
-				// Ӳƽ
-				plane_ptr[p] = DisparityPlane(x, y, norm, disp);
+void PatchMatchStereo::PyramidInitialization() const
+{
+	const sint32 width = width_;
+	const sint32 height = height_;
+	if (width <= 0 || height <= 0 || coarse_level_ == nullptr ||
+		plane_left_ == nullptr || plane_right_ == nullptr) {
+		return;
+	}
+	const sint32 width_coarse = coarse_level_->width_;
+	const sint32 height_coarse = coarse_level_->height_;
+
+	for (int k = 0; k < 2; k++) {
+		const auto* plane_coarse = k == 0 ? coarse_level_->plane_left_ : coarse_level_->plane_right_;
+		auto* plane_ptr = k == 0 ? plane_left_ : plane_right_;
+		pms_util::ParallelFor(0, height, pms_util::GetNumThreads(option_.num_threads), [&](const sint32& y, const sint32&) {
+			const sint32 yc = std::min(y / 2, height_coarse - 1);
+			for (sint32 x = 0; x < width; x++) {
+				const sint32 xc = std::min(x / 2, width_coarse - 1);
+				plane_ptr[y * width + x] = plane_coarse[yc * width_coarse + xc].to_finer_level();
 			}
-		}
+		});
 	}
 }
 
@@ -222,18 +504,8 @@ void PatchMatchStereo::ComputeGray() const
 	}
 
 	// ɫתҶ
-	for (sint32 n = 0; n < 2; n++) {
-		auto* color = (n == 0) ? img_left_ : img_right_;
-		auto* gray = (n == 0) ? gray_left_ : gray_right_;
-		for (sint32 i = 0; i < height; i++) {
-			for (sint32 j = 0; j < width; j++) {
-				const auto b = color[i * width * 3 + 3 * j];
-				const auto g = color[i * width * 3 + 3 * j + 1];
-				const auto r = color[i * width * 3 + 3 * j + 2];
-				gray[i * width + j] = uint8(r * 0.299 + g * 0.587 + b * 0.114);
-			}
-		}
-	}
+	pms_util::ComputeGray(img_left_, width, height, gray_left_);
+	pms_util::ComputeGray(img_right_, width, height, gray_right_);
 }
 
 void PatchMatchStereo::ComputeGradient() const
@@ -247,26 +519,11 @@ void PatchMatchStereo::ComputeGradient() const
 	}
 
 	// Sobelݶ
-	for (sint32 n = 0; n < 2; n++) {
-		auto* gray = (n == 0) ? gray_left_ : gray_right_;
-		auto* grad = (n == 0) ? grad_left_ : grad_right_;
-		for (int y = 1; y < height - 1; y++) {
-			for (int x = 1; x < width - 1; x++) {
-				const auto grad_x = (-gray[(y - 1) * width + x - 1] + gray[(y - 1) * width + x + 1]) +
-					(-2 * gray[y * width + x - 1] + 2 * gray[y * width + x + 1]) +
-					(-gray[(y + 1) * width + x - 1] + gray[(y + 1) * width + x + 1]);
-				const auto grad_y = (-gray[(y - 1) * width + x - 1] - 2 * gray[(y - 1) * width + x] - gray[(y - 1) * width + x + 1]) +
-					(gray[(y + 1) * width + x - 1] + 2 * gray[(y + 1) * width + x] + gray[(y + 1) * width + x + 1]);
-
-				// 8Ϊݶȵֵ255ʱݶȲɫλͬһ߶
-				grad[y * width + x].x = grad_x / 8;
-				grad[y * width + x].y = grad_y / 8;
-			}
-		}
-	}
+	pms_util::ComputeGradient(gray_left_, width, height, grad_left_);
+	pms_util::ComputeGradient(gray_right_, width, height, grad_right_);
 }
 
-void PatchMatchStereo::Propagation() const
+void PatchMatchStereo::Propagation()
 {
 	const sint32 width = width_;
 	const sint32 height = height_;
@@ -278,165 +535,167 @@ void PatchMatchStereo::Propagation() const
 		return;
 	}
 
-	// ͼƥ
-	const auto opion_left = option_;
+	// ͼƥͼʹòͬУ֡֡仯
+	auto opion_left = option_;
 	auto option_right = option_;
 	option_right.min_disparity = -opion_left.max_disparity;
 	option_right.max_disparity = -opion_left.min_disparity;
-
-	// ͼʵ
-	PMSPropagation propa_left(width, height, img_left_, img_right_, grad_left_, grad_right_, plane_left_, plane_right_, opion_left,cost_left_,cost_right_, disp_left_);
-	PMSPropagation propa_right(width, height, img_right_, img_left_, grad_right_, grad_left_, plane_right_, plane_left_, option_right, cost_right_, cost_left_, disp_right_);
-
-	// 
-	for (int k = 0; k < option_.num_iters; k++) {
-		propa_left.DoPropagation();
-		propa_right.DoPropagation();
+	const uint32 seed_offset = 2 * num_warm_frames_;
+	opion_left.seed = seed_ + seed_offset + 1;
+	option_right.seed = seed_ + seed_offset + 2;
+	// ͼʱһ̣߳ͼĲдͬһ
+	if (option_.is_concurrent_views) {
+		opion_left.num_threads = option_right.num_threads = std::max(pms_util::GetNumThreads(option_.num_threads) / 2, 1);
 	}
-}
-
-void PatchMatchStereo::LRCheck()
-{
-	const sint32 width = width_;
-	const sint32 height = height_;
 
-	const float32& threshold = option_.lrcheck_thres;
-
-	// k==0 : ͼһԼ
-	// k==1 : ͼһԼ
-	for (int k = 0; k < 2; k++) {
-		auto* disp_left = (k == 0) ? disp_left_ : disp_right_;
-		auto* disp_right = (k == 0) ? disp_right_ : disp_left_;
-		auto& mismatches = (k == 0) ? mismatches_left_ : mismatches_right_;
-		mismatches.clear();
+	// ֲ֡нϺõĳֵֻͽСŻΧ
+	sint32 num_iters = option_.num_iters;
+	if (is_warm_frame_) {
+		num_iters = option_.temporal_iters;
+		opion_left.refine_range = option_right.refine_range = option_.temporal_refine_range;
+	}
+	else if (coarse_level_) {
+		num_iters = option_.pyramid_iters;
+		opion_left.refine_range = option_right.refine_range = option_.pyramid_refine_range;
+	}
 
-		// ---һԼ
-		for (sint32 y = 0; y < height; y++) {
-			for (sint32 x = 0; x < width; x++) {
+	// ͼʵѡػ汾ʱʼ
+	pms_util::Timer timer;
+	auto* propa_left = PMSPropagation::Create(width, height, img_left_, img_right_, grad_left_, grad_right_, plane_left_, plane_right_, opion_left,cost_left_,cost_right_, disp_left_, &planar_left_, &planar_right_, &planar_left_sub_, &planar_right_sub_);
+	auto* propa_right = PMSPropagation::Create(width, height, img_right_, img_left_, grad_right_, grad_left_, plane_right_, plane_left_, option_right, cost_right_, cost_left_, disp_right_, &planar_right_, &planar_left_, &planar_right_sub_, &planar_left_sub_);
+
+	stats_.time_cost_init = timer.Elapsed();
+
+	// ƽ漰λڴӳļʱɨ跽Ԥȡд
+	if (option_.is_mapped_storage) {
+		const size_t row_plane = static_cast<size_t>(width) * sizeof(DisparityPlane);
+		const size_t row_cost = static_cast<size_t>(width) * sizeof(float32);
+		const sint32 band_rows = static_cast<sint32>(std::max<size_t>(Prefetch_Band_Bytes / (row_plane + row_cost), 1));
+		const auto prefetch = [this, row_plane, row_cost](const sint32& y_begin, const sint32& y_end) {
+			const size_t rows = y_end - y_begin;
+			// ͼһͼͬһУͼͬʱԤȡ
+			storage_plane_left_.Prefetch(y_begin * row_plane, rows * row_plane);
+			storage_plane_right_.Prefetch(y_begin * row_plane, rows * row_plane);
+			storage_cost_left_.Prefetch(y_begin * row_cost, rows * row_cost);
+			storage_cost_right_.Prefetch(y_begin * row_cost, rows * row_cost);
+		};
+		propa_left->SetRowPrefetch(prefetch, band_rows);
+		propa_right->SetRowPrefetch(prefetch, band_rows);
+	}
 
-				// ӰӲֵ
-				auto& disp = disp_left[y * width + x];
+	// ͼͼһͼдͨƽ
+	PlaneLocks locks_left, locks_right;
+	if (option_.is_concurrent_views) {
+		propa_left->SetPlaneLocks(&locks_left, &locks_right);
+		propa_right->SetPlaneLocks(&locks_right, &locks_left);
+	}
 
-				if (disp == Invalid_Float) {
-					mismatches.emplace_back(x, y);
-					continue;
-				}
+	// ¼ƽһαµĵֻб仯
+	PixelStamps stamps_left(option_.is_active_set ? width * height : 0);
+	PixelStamps stamps_right(option_.is_active_set ? width * height : 0);
+	if (option_.is_active_set) {
+		propa_left->SetPixelStamps(&stamps_left, &stamps_right);
+		propa_right->SetPixelStamps(&stamps_right, &stamps_left);
+	}
 
-				// ӲֵҵӰ϶Ӧͬ
-				const auto col_right = lround(x - disp);
+	// ֱ¼ͼÿεĺʱ
+	stats_.time_iter_left.assign(num_iters, 0.0);
+	stats_.time_iter_right.assign(num_iters, 0.0);
+	const auto propagate = [](PMSPropagation* propa, float64& time) {
+		const pms_util::Timer timer_iter;
+		propa->DoPropagation();
+		time = timer_iter.Elapsed();
+	};
+	// ÿεͳƣƽ汻µرʵرܾۺϴ
+	const sint32 num_threads = pms_util::GetNumThreads(option_.num_threads);
+	const float64 num_pixels = 2.0 * width * height;
+	uint64 num_changed = 0, num_visited = 0;
+	stats_.iter_cost.assign(1, TotalCost(num_threads));
+	sint32 k = 0;
+	while (k < num_iters) {
+		if (option_.is_concurrent_views) {
+			std::thread th_right(propagate, propa_right, std::ref(stats_.time_iter_right[k]));
+			propagate(propa_left, stats_.time_iter_left[k]);
+			th_right.join();
+		}
+		else {
+			propagate(propa_left, stats_.time_iter_left[k]);
+			propagate(propa_right, stats_.time_iter_right[k]);
+		}
+		++k;
+
+		auto counters = propa_left->GetCounters();
+		counters += propa_right->GetCounters();
+		const float64 changed_ratio = (counters.num_changed_pixels - num_changed) / num_pixels;
+		stats_.iter_active_ratio.push_back((counters.num_visited_pixels - num_visited) / num_pixels);
+		num_changed = counters.num_changed_pixels;
+		num_visited = counters.num_visited_pixels;
+		const float64 cost_prev = stats_.iter_cost.back();
+		const float64 cost = TotalCost(num_threads);
+		stats_.iter_changed_ratio.push_back(changed_ratio);
+		stats_.iter_cost.push_back(cost);
+
+		// ½رֵʱΪ
+		// ƽŻ΢СŶ£һɴ½ȴﵽֵ
+		if (option_.converge_thres > 0.0f && (cost_prev - cost < option_.converge_thres * cost_prev ||
+			changed_ratio < option_.converge_thres)) {
+			break;
+		}
+	}
+	stats_.time_iter_left.resize(k);
+	stats_.time_iter_right.resize(k);
+	stats_.counters_left = propa_left->GetCounters();
+	stats_.counters_right = propa_right->GetCounters();
 
-				if (col_right >= 0 && col_right < width) {
-					// ӰͬصӲֵ
-					auto& disp_r = disp_right[y * width + col_right];
+	delete propa_left;
+	delete propa_right;
+}
 
-					// жӲֵǷһ£ֵֵΪһ£
-					// ڱͼӲֵ෴
-					if (abs(disp + disp_r) > threshold) {
-						// ӲֵЧ
-						disp = Invalid_Float;
-						mismatches.emplace_back(x, y);
-					}
-				}
-				else {
-					// ͨӲֵӰҲͬأӰΧ
-					disp = Invalid_Float;
-					mismatches.emplace_back(x, y);
-				}
-			}
+float64 PatchMatchStereo::TotalCost(const sint32& num_threads) const
+{
+	// вͣеĺͰк˳ۼӣ߳޹
+	vector<float64> row_sums(height_, 0.0);
+	pms_util::ParallelFor(0, height_, num_threads, [&](const sint32& y, const sint32&) {
+		float64 sum = 0.0;
+		for (sint32 x = 0; x < width_; x++) {
+			sum += cost_left_[y * width_ + x];
+			sum += cost_right_[y * width_ + x];
 		}
+		row_sums[y] = sum;
+	});
+	float64 total = 0.0;
+	for (const auto& sum : row_sums) {
+		total += sum;
 	}
+	return total;
+}
+
+void PatchMatchStereo::LRCheck()
+{
+	// ȼͼͼʱʹͼӲͼ
+	post_.LRCheck(disp_left_, disp_right_, mismatches_left_);
+	post_.LRCheck(disp_right_, disp_left_, mismatches_right_);
 }
 
 void PatchMatchStereo::FillHolesInDispMap()
 {
-	const sint32 width = width_;
-	const sint32 height = height_;
-	if (width <= 0 || height <= 0 ||
+	if (width_ <= 0 || height_ <= 0 ||
 		disp_left_ == nullptr || disp_right_ == nullptr ||
 		plane_left_ == nullptr || plane_right_ == nullptr) {
 		return;
 	}
 
-	const auto& option = option_;
-
-	// k==0 : ͼӲ
-	// k==1 : ͼӲ
-	for (int k = 0; k < 2; k++) {
-		auto& mismatches = (k == 0) ? mismatches_left_ : mismatches_right_;
-		if(mismatches.empty()) {
-			continue;
-		}
-		const auto* img_ptr = (k == 0) ? img_left_ : img_right_;
-		const auto* plane_ptr = (k == 0) ? plane_left_ : plane_right_;
-		auto* disp_ptr = (k == 0) ? disp_left_ : disp_right_;
-		vector<float32> fill_disps(mismatches.size());		// 洢ÿصӲ
-		for (auto n = 0u; n < mismatches.size();n++) {
-			auto& pix = mismatches[n];
-			const sint32 x = pix.first;
-			const sint32 y = pix.second;
-			vector<DisparityPlane> planes;
-
-			// ҸѰһЧأ¼ƽ
-			sint32 xs = x + 1;
-			while (xs < width) {
-				if (disp_ptr[y * width + xs] != Invalid_Float) {
-					planes.push_back(plane_ptr[y * width + xs]);
-					break;
-				}
-				xs++;
-			}
-			xs = x - 1;
-			while (xs >= 0) {
-				if (disp_ptr[y * width + xs] != Invalid_Float) {
-					planes.push_back(plane_ptr[y * width + xs]);
-					break;
-				}
-				xs--;
-			}
-
-			if(planes.empty()) {
-				continue;
-			}
-			else if (planes.size() == 1u) {
-				fill_disps[n] = planes[0].to_disparity(x, y);
-			}
-			else {
-				// ѡСӲ
-				const auto d1 = planes[0].to_disparity(x, y);
-				const auto d2 = planes[1].to_disparity(x, y);
-				fill_disps[n] = abs(d1) < abs(d2) ? d1 : d2;
-			}
-		}
-		for (auto n = 0u; n < mismatches.size(); n++) {
-			auto& pix = mismatches[n];
-			const sint32 x = pix.first;
-			const sint32 y = pix.second;
-			disp_ptr[y * width + x] = fill_disps[n];
-		}
-
-		// Ȩֵ˲
-		pms_util::WeightedMedianFilter(img_ptr, width, height, option.patch_size, option.gamma, mismatches, disp_ptr);
-	}
+	post_.FillHoles(img_left_, plane_left_, mismatches_left_, disp_left_);
+	post_.FillHoles(img_right_, plane_right_, mismatches_right_, disp_right_);
 }
 
 void PatchMatchStereo::PlaneToDisparity() const
 {
-	const sint32 width = width_;
-	const sint32 height = height_;
-	if (width <= 0 || height <= 0 ||
+	if (width_ <= 0 || height_ <= 0 ||
 		disp_left_ == nullptr || disp_right_ == nullptr ||
 		plane_left_ == nullptr || plane_right_ == nullptr) {
 		return;
 	}
-	for (int k = 0; k < 2; k++) {
-		auto* plane_ptr = (k == 0) ? plane_left_ : plane_right_;
-		auto* disp_ptr = (k == 0) ? disp_left_ : disp_right_;
-		for (sint32 y = 0; y < height; y++) {
-			for (sint32 x = 0; x < width; x++) {
-				const sint32 p = y * width + x;
-				const auto& plane = plane_ptr[p];
-				disp_ptr[p] = plane.to_disparity(x, y);
-			}
-		}
-	}
+	post_.PlaneToDisparity(plane_left_, disp_left_);
+	post_.PlaneToDisparity(plane_right_, disp_right_);
 }
@@ -7,6 +7,10 @@
 #pragma once
 #include <vector>
 #include "pms_types.h"
+#include "pms_planar.h"
+#include "pms_storage.h"
+#include "pms_postprocess.h"
+#include "pms_random.hpp"
 
 /**
  * \brief PatchMatch
@@ -35,7 +39,18 @@ public:
 	bool Match(const uint8* img_left, const uint8* img_right, float32* disp_left);
 
 	/**
-	* \brief 
+	 * \brief һ֡һ֡˶Ƶģʽʱһ֡Ӳƽ˶һMatchЧ
+	 * ͼʹͬһ˶ǰ֡(x,y)ĳʼƽȡһ֡(x-motion_x,y-motion_y)
+	 * \param motion_x	x˶Ӱȳߴ磬Ϊnullptrʱ˶
+	 * \param motion_y	y˶Ӱȳߴ
+	 */
+	void SetFrameMotion(const float32* motion_x, const float32* motion_y);
+
+	/** \brief Ƶ״̬糡лʱһ֡ʼ */
+	void ClearTemporalState();
+
+	/**
+	* \brief 裬ߴ缰ڴ沼֣洢ʽʱѷڴ棬ֻ²
 	* \param width		룬Ӱ
 	* \param height		룬Ӱ
 	* \param option		룬㷨
@@ -51,6 +66,21 @@ public:
 	float* GetDisparityMap(const sint32& view) const;
 
 
+	/**
+	 * \brief ָߴͲʼƥʱڴ棨ֽڣ㼰棨Ӱ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param option		㷨
+	 * \return ڴֽ
+	 */
+	static sint64 EstimateMemory(const sint32& width, const sint32& height, const PMSOption& option);
+
+	/**
+	 * \brief ȡһƥͳϢ׶κʱ
+	 * ģʽ´ֲƥʱtime_initֻ
+	 */
+	const PMSStatistics& GetStatistics() const;
+
 	/**
 	 * \brief ȡݶͼָ
 	 * \param view 0-ͼ 1-ͼ
@@ -58,9 +88,46 @@ public:
 	 */
 	PGradient* GetGradientMap(const sint32& view) const;
 private:
+	/**
+	 * \brief һĳߴ缰
+	 * \param width			Ӱ
+	 * \param height			Ӱ
+	 * \param option			
+	 * \param width_coarse		һӰ
+	 * \param height_coarse		һӰ
+	 * \param option_coarse		һ
+	 * \return ǷҪһ
+	 */
+	static bool GetCoarseLevel(const sint32& width, const sint32& height, const PMSOption& option,
+		sint32& width_coarse, sint32& height_coarse, PMSOption& option_coarse);
+
+	/**
+	 * \brief ͨݣҪʱˮƽķͨݣߴ缰ʽʱڴ
+	 * \param option	
+	 * \return Ƿɹ
+	 */
+	bool CreatePlanarImages(const PMSOption& option);
+
 	/** \brief ʼ */
 	void RandomInitialization() const;
 
+	/**
+	 * \brief (x,y)ӲӲƽ
+	 * \param rng		
+	 * \param x			x
+	 * \param y			y
+	 * \param sign		ӲţͼΪ1ͼΪ-1
+	 * \param disp		Ӳ
+	 * \param plane		Ӳƽ
+	 */
+	void RandomPlane(PMSRandom& rng, const sint32& x, const sint32& y, const sint32& sign, float32& disp, DisparityPlane& plane) const;
+
+	/** \brief Ƶģʽ£һ֡Ӳƽ棨˶󣩵õ֡ĳʼƽ棬Բʼ */
+	void TemporalInitialization();
+
+	/** \brief ģʽ£ɴһӲƽϲõĳʼƽ */
+	void PyramidInitialization() const;
+
 	/** \brief Ҷ */
 	void ComputeGray() const;
 
@@ -68,7 +135,13 @@ private:
 	void ComputeGradient() const;
 
 	/** \brief  */
-	void Propagation() const;
+	void Propagation();
+
+	/**
+	 * \brief ͼܾۺϴۣжϴǷ
+	 * \param num_threads	߳
+	 */
+	float64 TotalCost(const sint32& num_threads) const;
 
 	/** \brief һԼ	 */
 	void LRCheck();
@@ -107,6 +180,15 @@ private:
 	/** \brief Ӱݶ	 */
 	PGradient* grad_right_;
 
+	/** \brief Ӱͨݣɫݶȣչ߽磩ۼȡ	 */
+	PlanarImage planar_left_;
+	/** \brief Ӱͨ	 */
+	PlanarImage planar_right_;
+	/** \brief ӰˮƽķͨݣΪͼͬӰ񣬽subpixel_factor>1ʱ	 */
+	PlanarImage planar_left_sub_;
+	/** \brief ӰˮƽķͨݣΪͼͬӰ	 */
+	PlanarImage planar_right_sub_;
+
 	/** \brief Ӱۺϴ	 */
 	float32* cost_left_;
 	/** \brief Ӱۺϴ	 */
@@ -122,6 +204,33 @@ private:
 	/** \brief Ӱƽ漯	*/
 	DisparityPlane* plane_right_;
 
+	/** \brief ƽ漯ۺϴݵĴ洢λڴӳļ	*/
+	PMSStorage storage_plane_left_;
+	PMSStorage storage_plane_right_;
+	PMSStorage storage_cost_left_;
+	PMSStorage storage_cost_right_;
+
+	/** \brief һƥʵ߶ƥʱΪnullptr	*/
+	PatchMatchStereo* coarse_level_;
+	/** \brief һӰ	*/
+	uint8* img_coarse_left_;
+	uint8* img_coarse_right_;
+
+	/** \brief ƥʹõ	*/
+	uint32 seed_;
+
+	/** \brief ƵģʽǷһ֡Ӳƽ棬֡ǷΪ֡֡	*/
+	bool has_prev_frame_;
+	bool is_warm_frame_;
+	uint32 num_warm_frames_;
+	/** \brief Ƶģʽһ֡˶˶ƽ滺	*/
+	const float32* motion_x_;
+	const float32* motion_y_;
+	vector<DisparityPlane> warp_planes_;
+
+	/** \brief һƥͳϢ	*/
+	PMSStatistics stats_;
+
 	/** \brief Ƿʼ־	*/
 	bool is_initialized_;
 
@@ -129,5 +238,8 @@ private:
 	vector<pair<int, int>> mismatches_left_;
 	vector<pair<int, int>> mismatches_right_;
 
+	/** \brief ̻߳ڶƥ֮临	*/
+	PMSPostProcessor post_;
+
 };
 
@@ -7,7 +7,12 @@
 #ifndef PATCH_MATCH_STEREO_COST_HPP_
 #define PATCH_MATCH_STEREO_COST_HPP_
 #include "pms_types.h"
+#include "pms_simd.h"
+#include "pms_planar.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
 
 #define COST_PUNISH 120.0f  // NOLINT(cppcoreguidelines-macro-usage)
 
@@ -85,12 +90,19 @@ public:
 
 /**
  * \brief ۼPatchMatchSteroԭĴۼ
+ * Ϊۼģֱӵ÷ԱComputeWeightsComputeAɰڳߴڱػ
  */
-class CostComputerPMS : public CostComputer {
+class CostComputerPMS final : public CostComputer {
 public:
+	/** \brief Ȩֵ */
+	typedef float32 Weight;
+
+	/** \brief ȨֵԪǰpatch_size*patch_sizeΪд洢Ȩֵ */
+	static sint32 WeightsSize(const sint32& patch_size) { return patch_size * patch_size; }
 
 	/** \brief PMSۼĬϹ */
-	CostComputerPMS(): grad_left_(nullptr), grad_right_(nullptr), gamma_(0), alpha_(0), tau_col_(0), tau_grad_(0) {} ;
+	CostComputerPMS(): grad_left_(nullptr), grad_right_(nullptr), gamma_(0), alpha_(0), tau_col_(0), tau_grad_(0),
+	                   sample_step_(1), simd_level_(PMS_SIMD_SCALAR), kernel_args_(), kernel_(nullptr) {} ;
 
 	/**
 	 * \brief PMSۼι
@@ -118,6 +130,70 @@ public:
 		alpha_ = alpha;
 		tau_col_ = t_col;
 		tau_grad_ = t_grad;
+
+		// ˺÷ͨӰú˺
+		kernel_args_ = {};
+		kernel_args_.width = width;
+		kernel_args_.height = height;
+		kernel_args_.patch_size = patch_size;
+		kernel_args_.sample_step = 1;
+		kernel_args_.min_disp = static_cast<float32>(min_disp);
+		kernel_args_.max_disp = static_cast<float32>(max_disp);
+		kernel_args_.alpha = alpha;
+		kernel_args_.tau_col = t_col;
+		kernel_args_.tau_grad = t_grad;
+		kernel_args_.subpixel = 1;
+		sample_step_ = 1;
+		simd_level_ = PMS_SIMD_SCALAR;
+		kernel_ = nullptr;
+	}
+
+	/**
+	 * \brief ôڲΪ׼ÿstepСȡһأƽģͲ
+	 * ͬһصĸѡƽʹͬĲأۿֱӱȽ
+	 * \param step		1Ϊܴ
+	 */
+	void SetSampleStep(const sint32& step)
+	{
+		sample_step_ = std::max(1, step);
+		kernel_args_.sample_step = sample_step_;
+	}
+
+	/**
+	 * \brief ۺϴʹõSIMD𣬰CPUIDѡ˺
+	 * \param level		PMSSimdLevelPMS_SIMD_SCALARʱʹñʵ
+	 */
+	void SetSimdLevel(const sint32& level)
+	{
+		simd_level_ = level;
+		UpdateKernel();
+	}
+
+	/**
+	 * \brief Ӱķͨݣۺϴ۸ɺ˺ӷͨݶȡ
+	 * δʱۺϴʹð3ͨ洢ݶȡıʵ
+	 * \param planar_left		ӰͨݣߴӰһ£չСpatch_size/2
+	 * \param planar_right	ӰͨݣпӰһ
+	 * \param planar_right_sub	ӰˮƽķͨݣʱֱͬӶȡʵʱֵ
+	 */
+	void SetPlanarImages(const PlanarImage* planar_left, const PlanarImage* planar_right, const PlanarImage* planar_right_sub = nullptr)
+	{
+		const bool valid = planar_left != nullptr && planar_right != nullptr &&
+			!planar_left->is_fixed() && !planar_right->is_fixed() &&
+			planar_left->width() == width_ && planar_left->height() == height_ &&
+			planar_right->width() == width_ && planar_right->height() == height_ &&
+			planar_left->stride() == planar_right->stride() && planar_left->pad() >= patch_size_ / 2;
+		const bool valid_sub = valid && planar_right_sub != nullptr && !planar_right_sub->is_fixed() && planar_right_sub->factor() > 1 &&
+			planar_right_sub->width() == width_ && planar_right_sub->height() == height_;
+		const PlanarImage* right = valid_sub ? planar_right_sub : planar_right;
+		for (sint32 n = 0; n < PlanarImage::NUM_CHANNELS; n++) {
+			kernel_args_.left[n] = valid ? planar_left->channel(n) : nullptr;
+			kernel_args_.right[n] = valid ? right->channel(n) : nullptr;
+		}
+		kernel_args_.stride = valid ? planar_left->stride() : 0;
+		kernel_args_.right_stride = valid ? right->stride() : 0;
+		kernel_args_.subpixel = valid ? right->factor() : 1;
+		UpdateKernel();
 	}
 
 	/**
@@ -136,12 +212,12 @@ public:
 		// ɫռ
 		const auto col_p = GetColor(img_left_, x, y);
 		const auto col_q = GetColor(img_right_, xr, y);
-		const auto dc = std::min(abs(col_p.b - col_q.x) + abs(col_p.g - col_q.y) + abs(col_p.r - col_q.z), tau_col_);
+		const auto dc = std::min(std::abs(col_p.b - col_q.x) + std::abs(col_p.g - col_q.y) + std::abs(col_p.r - col_q.z), tau_col_);
 
 		// ݶȿռ
 		const auto grad_p = GetGradient(grad_left_, x, y);
 		const auto grad_q = GetGradient(grad_right_, xr, y);
-		const auto dg = std::min(abs(grad_p.x - grad_q.x)+ abs(grad_p.y - grad_q.y), tau_grad_);
+		const auto dg = std::min(std::abs(grad_p.x - grad_q.x)+ std::abs(grad_p.y - grad_q.y), tau_grad_);
 
 		// ֵ
 		return (1 - alpha_) * dc + alpha_ * dg;
@@ -164,11 +240,11 @@ public:
 		}
 		// ɫռ
 		const auto col_q = GetColor(img_right_, xr, y);
-		const auto dc = std::min(abs(col_p.b - col_q.x) + abs(col_p.g - col_q.y) + abs(col_p.r - col_q.z), tau_col_);
+		const auto dc = std::min(std::abs(col_p.b - col_q.x) + std::abs(col_p.g - col_q.y) + std::abs(col_p.r - col_q.z), tau_col_);
 
 		// ݶȿռ
 		const auto grad_q = GetGradient(grad_right_, xr, y);
-		const auto dg = std::min(abs(grad_p.x - grad_q.x) + abs(grad_p.y - grad_q.y), tau_grad_);
+		const auto dg = std::min(std::abs(grad_p.x - grad_q.x) + std::abs(grad_p.y - grad_q.y), tau_grad_);
 
 		// ֵ
 		return (1 - alpha_) * dc + alpha_ * dg;
@@ -185,11 +261,12 @@ public:
 	inline float32 ComputeA(const sint32& x, const sint32& y, const DisparityPlane& p) const
 	{
 		const auto pat = patch_size_ / 2;
+		const sint32 step = sample_step_;
 		const auto& col_p = GetColor(img_left_, x, y);
 		float32 cost = 0.0f;
-		for (sint32 r = -pat; r <= pat; r++) {
+		for (sint32 r = pms_simd::FirstSample(-pat, step); r <= pat; r += step) {
 			const sint32 yr = y + r;
-			for (sint32 c = -pat; c <= pat; c++) {
+			for (sint32 c = pms_simd::FirstSample(-pat, step); c <= pat; c += step) {
 				const sint32 xc = x + c;
 				if (yr < 0 || yr > height_ - 1 || xc < 0 || xc > width_ - 1) {
 					continue;
@@ -218,6 +295,108 @@ public:
 		return cost;
 	}
 
+	/**
+	 * \brief pֲڸصӦȨֵ
+	 * ȨֵֻpqɫйأӲƽ޹أһμɹpкѡƽ渴
+	 * \tparam PATCH	ڳߴ磬Ϊ0ʱʹpatch_size_
+	 * \param x		px
+	 * \param y		py
+	 * \param weights	Ȩֵ飬СΪpatch_size*patch_sizeд洢Ӱ⼰δزֵ
+	 */
+	template <sint32 PATCH = 0>
+	inline void ComputeWeights(const sint32& x, const sint32& y, float32* weights) const
+	{
+		const sint32 patch_size = PATCH > 0 ? PATCH : patch_size_;
+		const sint32 pat = patch_size / 2;
+		if (x >= pat && x < width_ - pat && y >= pat && y < height_ - pat) {
+			// λӰڣPATCHΪʱѭ߽Ϊڳ
+			ComputeWeights(x, y, -pat, pat, -pat, pat, patch_size, weights);
+		}
+		else {
+			ComputeWeights(x, y, std::max(-pat, -y), std::min(pat, height_ - 1 - y),
+				std::max(-pat, -x), std::min(pat, width_ - 1 - x), patch_size, weights);
+		}
+	}
+
+	/**
+	 * \brief ӰpڶѡӲƽµľۺϴֵ
+	 * ֻһδڣÿصɫݶȺȨֵֻȡһΣкѡƽ
+	 * \tparam PATCH	ڳߴ磬Ϊ0ʱʹpatch_size_˺ʱڳߴѡ
+	 * \param x			px
+	 * \param y 		py
+	 * \param planes	ѡƽ
+	 * \param num		ѡƽ
+	 * \param weights	pĴȨֵComputeWeights
+	 * \param costs		ѡƽľۺϴֵ
+	 * \return ۼӵĴڲѡƽ֮ͣ
+	 */
+	template <sint32 PATCH = 0>
+	inline sint64 ComputeA(const sint32& x, const sint32& y, const DisparityPlane* planes, const sint32& num, const float32* weights, float32* costs) const
+	{
+		return ComputeABounded<PATCH>(x, y, planes, num, weights, Unbounded_Cost, costs);
+	}
+
+	/**
+	 * \brief ޵ۺϴۼ
+	 * ۾Ǹֺֻÿۼ괰ڵһмһΣֺͲС޵ĺѡƽֹͣۼӣ
+	 * ֵΪòֺͣСޣѡƽֵComputeAȫһ
+	 * ֻܴС޵ĺѡƽʱComputeAͬ
+	 * \tparam PATCH	ڳߴ磬Ϊ0ʱʹpatch_size_
+	 * \param x			px
+	 * \param y 		py
+	 * \param planes	ѡƽ
+	 * \param num		ѡƽ
+	 * \param weights	pĴȨֵComputeWeights
+	 * \param bound		ޣһΪpĵǰ
+	 * \param costs		ѡƽľۺϴֵ
+	 * \return ۼӵĴڲѡƽ֮ͣǰֹͣвƣ
+	 */
+	template <sint32 PATCH = 0>
+	inline sint64 ComputeABounded(const sint32& x, const sint32& y, const DisparityPlane* planes, const sint32& num, const float32* weights,
+		const float32& bound, float32* costs) const
+	{
+		if (kernel_) {
+			return kernel_(kernel_args_, x, y, planes, num, weights, bound, costs);
+		}
+		const sint32 patch_size = PATCH > 0 ? PATCH : patch_size_;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height_ - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width_ - 1 - x);
+		const sint64 row_samples = static_cast<sint64>((c_max - pms_simd::FirstSample(c_min, sample_step_)) / sample_step_ + 1) * num;
+		sint64 samples = 0;
+		bool is_exceeded = false;
+		for (sint32 k = 0; k < num; k++) {
+			costs[k] = 0.0f;
+		}
+		for (sint32 r = pms_simd::FirstSample(r_min, sample_step_); r <= r_max && !is_exceeded; r += sample_step_) {
+			samples += row_samples;
+			const sint32 yr = y + r;
+			const float32* w_row = weights + (r + pat) * patch_size + pat;
+			for (sint32 c = pms_simd::FirstSample(c_min, sample_step_); c <= c_max; c += sample_step_) {
+				const sint32 xc = x + c;
+				const auto& col_q = GetColor(img_left_, xc, yr);
+				const auto grad_q = GetGradient(grad_left_, xc, yr);
+				const float32 w = w_row[c];
+				for (sint32 k = 0; k < num; k++) {
+					// Ӳֵ
+					const float32 d = planes[k].to_disparity(xc, yr);
+					if (d < min_disp_ || d > max_disp_) {
+						costs[k] += COST_PUNISH;
+						continue;
+					}
+					// ۺϴ
+					costs[k] += w * Compute(col_q, grad_q, xc, yr, d);
+				}
+			}
+			// кѡƽʱֹͣ
+			is_exceeded = true;
+			for (sint32 k = 0; k < num && is_exceeded; k++) {
+				is_exceeded = costs[k] >= bound;
+			}
+		}
+		return samples;
+	}
+
 	/**
 	* \brief ȡصɫֵ
 	* \param img_data	ɫ,3ͨ
@@ -286,6 +465,32 @@ public:
 	}
 
 private:
+	/** \brief 㴰[r_min,r_max]С[c_min,c_max]صȨֵ */
+	inline void ComputeWeights(const sint32& x, const sint32& y, const sint32& r_min, const sint32& r_max,
+		const sint32& c_min, const sint32& c_max, const sint32& patch_size, float32* weights) const
+	{
+		const sint32 pat = patch_size / 2;
+		const auto& col_p = GetColor(img_left_, x, y);
+		for (sint32 r = pms_simd::FirstSample(r_min, sample_step_); r <= r_max; r += sample_step_) {
+			float32* w_row = weights + (r + pat) * patch_size + pat;
+			for (sint32 c = pms_simd::FirstSample(c_min, sample_step_); c <= c_max; c += sample_step_) {
+				const auto& col_q = GetColor(img_left_, x + c, y + r);
+				const auto dc = abs(col_p.r - col_q.r) + abs(col_p.g - col_q.g) + abs(col_p.b - col_q.b);
+#ifdef USE_FAST_EXP
+				w_row[c] = static_cast<float32>(fast_exp(double(-dc / gamma_)));
+#else
+				w_row[c] = exp(-dc / gamma_);
+#endif
+			}
+		}
+	}
+
+	/** \brief SIMDǷзͨѡ˺ */
+	void UpdateKernel()
+	{
+		kernel_ = kernel_args_.left[0] != nullptr ? pms_simd::GetCostKernel(simd_level_, patch_size_, kernel_args_.subpixel > 1) : nullptr;
+	}
+
 	/** \brief Ӱݶ */
 	const PGradient* grad_left_;
 	/** \brief Ӱݶ */
@@ -299,6 +504,247 @@ private:
 	float32 tau_col_;
 	/** \brief tau_grad */
 	float32 tau_grad_;
+
+	/** \brief ڲ */
+	sint32 sample_step_;
+	/** \brief ʹõSIMD */
+	sint32 simd_level_;
+	/** \brief ˺ */
+	PMSCostKernelArgs kernel_args_;
+	/** \brief ˺Ϊnullptrʱʹð3ͨ洢ݶȡıʵ */
+	PMSCostKernel kernel_;
+};
+
+/**
+ * \brief ۼPatchMatchSteroԭĴ۵16λʵ
+ * ɫݶȡint16ʽķͨݣӰλΪ1/32أԲֵ
+ * ضϾԲش1/32ΪλȨֵɫõ8λСۺϴ۰int32ۼ
+ * ۺϴΪCostComputerPMSĽֵӲΧжCostComputerPMSȫһ
+ */
+class CostComputerPMSFixed final : public CostComputer {
+public:
+	/** \brief Ȩֵͣʽ1.0Ӧ256 */
+	typedef sint16 Weight;
+
+	/** \brief ȨֵԪĩβԤ16Ԫع˺ȡ */
+	static sint32 WeightsSize(const sint32& patch_size) { return patch_size * patch_size + 16; }
+
+	/**
+	 * \brief жϲǷڶʵֵȡֵΧڣڵint32ۼֵ
+	 * \param patch_size	ֲPatchС
+	 * \param alpha			alphaֵ
+	 * \param t_col			tau_colֵ
+	 * \param t_grad		tau_gradֵ
+	 */
+	static bool IsSupported(const sint32& patch_size, const float32& alpha, const float32& t_col, const float32& t_grad)
+	{
+		PMSCostKernelArgsFixed args;
+		Quantize(alpha, t_col, t_grad, args);
+		const sint64 max_cost = std::max<sint64>(args.punish,
+			((args.tau_col * args.alpha_col) >> 16) + ((args.tau_grad * args.alpha_grad) >> 16));
+		const sint64 max_sum = static_cast<sint64>(patch_size) * patch_size * (max_cost << Fixed_Weight_Bits);
+		return max_sum <= std::numeric_limits<sint32>::max();
+	}
+
+	/**
+	 * \brief ۼι죬ͬCostComputerPMS
+	 */
+	CostComputerPMSFixed(const uint8* img_left, const uint8* img_right, const PGradient* grad_left, const PGradient* grad_right, const sint32& width, const sint32& height, const sint32& patch_size,
+		const sint32& min_disp, const sint32& max_disp,
+		const float32& gamma, const float32& alpha, const float32& t_col, const float32 t_grad) :
+		CostComputer(img_left, img_right, width, height, patch_size, min_disp, max_disp) {
+		grad_left_ = grad_left;
+		grad_right_ = grad_right;
+
+		// ɫ0~765ȨֵĲұ
+		for (sint32 dc = 0; dc < Weight_Lut_Size; dc++) {
+#ifdef USE_FAST_EXP
+			const double w = fast_exp(double(-dc / gamma));
+#else
+			const double w = exp(-dc / gamma);
+#endif
+			weight_lut_[dc] = static_cast<Weight>(lround(w * (1 << Fixed_Weight_Bits)));
+		}
+
+		// ˺÷ͨӰú˺
+		kernel_args_ = {};
+		kernel_args_.width = width;
+		kernel_args_.height = height;
+		kernel_args_.patch_size = patch_size;
+		kernel_args_.sample_step = 1;
+		kernel_args_.min_disp = static_cast<float32>(min_disp);
+		kernel_args_.max_disp = static_cast<float32>(max_disp);
+		Quantize(alpha, t_col, t_grad, kernel_args_);
+		sample_step_ = 1;
+		simd_level_ = PMS_SIMD_SCALAR;
+		kernel_ = nullptr;
+	}
+
+	/** \brief ôڲͬCostComputerPMS::SetSampleStep */
+	void SetSampleStep(const sint32& step)
+	{
+		sample_step_ = std::max(1, step);
+		kernel_args_.sample_step = sample_step_;
+	}
+
+	/** \brief ۺϴʹõSIMD𣬸λһ */
+	void SetSimdLevel(const sint32& level)
+	{
+		simd_level_ = level;
+		UpdateKernel();
+	}
+
+	/**
+	 * \brief ӰķͨݣΪint16ʽۺϴ۲
+	 * \param planar_left		ӰͨݣߴӰһ£չСpatch_size/2
+	 * \param planar_right	ӰͨݣпӰһ
+	 * \param planar_right_sub	ʹãʵֵȡλ
+	 */
+	void SetPlanarImages(const PlanarImage* planar_left, const PlanarImage* planar_right, const PlanarImage* /*planar_right_sub*/ = nullptr)
+	{
+		const bool valid = planar_left != nullptr && planar_right != nullptr &&
+			planar_left->is_fixed() && planar_right->is_fixed() &&
+			planar_left->width() == width_ && planar_left->height() == height_ &&
+			planar_right->width() == width_ && planar_right->height() == height_ &&
+			planar_left->stride() == planar_right->stride() && planar_left->pad() >= patch_size_ / 2;
+		for (sint32 n = 0; n < PlanarImage::NUM_CHANNELS; n++) {
+			kernel_args_.left[n] = valid ? planar_left->channel16(n) : nullptr;
+			kernel_args_.right[n] = valid ? planar_right->channel16(n) : nullptr;
+		}
+		kernel_args_.stride = valid ? planar_left->stride() : 0;
+		UpdateKernel();
+	}
+
+	/**
+	 * \brief ӰpӲΪdʱĴֵ㣬ظֵ
+	 * \param x		px
+	 * \param y		py
+	 * \param d		Ӳֵ
+	 * \return ֵ
+	 */
+	inline float32 Compute(const sint32& x, const sint32& y, const float32& d) override
+	{
+		const auto& args = kernel_args_;
+		const float32 xr = x - d;
+		sint32 cost = args.out_cost;
+		if (xr >= 0.0f && xr < static_cast<float32>(width_)) {
+			const sint32 frac_one = 1 << Fixed_Frac_Bits;
+			const sint32 q = static_cast<sint32>(xr * static_cast<float32>(frac_one));
+			const sint32 x1 = q >> Fixed_Frac_Bits;
+			const sint32 x2 = std::min(x1 + 1, width_ - 1);
+			const sint32 f = q & (frac_one - 1);
+			const uint8* col_p = img_left_ + (y * width_ + x) * 3;
+			const uint8* col_q1 = img_right_ + (y * width_ + x1) * 3;
+			const uint8* col_q2 = img_right_ + (y * width_ + x2) * 3;
+			sint32 dc = 0;
+			for (sint32 n = 0; n < 3; n++) {
+				dc += abs(col_p[n] * frac_one - (col_q1[n] * (frac_one - f) + col_q2[n] * f));
+			}
+			const auto& grad_p = grad_left_[y * width_ + x];
+			const auto& grad_q1 = grad_right_[y * width_ + x1];
+			const auto& grad_q2 = grad_right_[y * width_ + x2];
+			const sint32 dg = abs(grad_p.x * frac_one - (grad_q1.x * (frac_one - f) + grad_q2.x * f)) +
+				abs(grad_p.y * frac_one - (grad_q1.y * (frac_one - f) + grad_q2.y * f));
+			cost = ((std::min(dc, static_cast<sint32>(args.tau_col)) * args.alpha_col) >> 16) +
+				((std::min(dg, static_cast<sint32>(args.tau_grad)) * args.alpha_grad) >> 16);
+		}
+		return static_cast<float32>(cost) / (1 << Fixed_Frac_Bits);
+	}
+
+	/**
+	 * \brief pֲڸصĶȨֵɫõ
+	 * \tparam PATCH	ڳߴ磬Ϊ0ʱʹpatch_size_
+	 * \param x		px
+	 * \param y		py
+	 * \param weights	Ȩֵ飬СΪWeightsSize(patch_size)д洢Ӱ⼰δزֵ
+	 */
+	template <sint32 PATCH = 0>
+	inline void ComputeWeights(const sint32& x, const sint32& y, Weight* weights) const
+	{
+		const sint32 patch_size = PATCH > 0 ? PATCH : patch_size_;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height_ - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width_ - 1 - x);
+		const uint8* col_p = img_left_ + (y * width_ + x) * 3;
+		for (sint32 r = pms_simd::FirstSample(r_min, sample_step_); r <= r_max; r += sample_step_) {
+			Weight* w_row = weights + (r + pat) * patch_size + pat;
+			const uint8* img_row = img_left_ + (y + r) * width_ * 3;
+			for (sint32 c = pms_simd::FirstSample(c_min, sample_step_); c <= c_max; c += sample_step_) {
+				const uint8* col_q = img_row + (x + c) * 3;
+				const sint32 dc = abs(col_p[0] - col_q[0]) + abs(col_p[1] - col_q[1]) + abs(col_p[2] - col_q[2]);
+				w_row[c] = weight_lut_[dc];
+			}
+		}
+	}
+
+	/** \brief ۺϴۣͬCostComputerPMS::ComputeAȨֵΪʽ */
+	template <sint32 PATCH = 0>
+	inline sint64 ComputeA(const sint32& x, const sint32& y, const DisparityPlane* planes, const sint32& num, const Weight* weights, float32* costs) const
+	{
+		return ComputeABounded<PATCH>(x, y, planes, num, weights, Unbounded_Cost, costs);
+	}
+
+	/**
+	 * \brief ޵ۺϴۼ㣬ͬCostComputerPMS::ComputeABounded
+	 * δint16ʽķͨʱ޷㣬ѡƽֵΪUnbounded_Cost
+	 */
+	template <sint32 PATCH = 0>
+	inline sint64 ComputeABounded(const sint32& x, const sint32& y, const DisparityPlane* planes, const sint32& num, const Weight* weights,
+		const float32& bound, float32* costs) const
+	{
+		if (kernel_) {
+			return kernel_(kernel_args_, x, y, planes, num, weights, bound, costs);
+		}
+		for (sint32 k = 0; k < num; k++) {
+			costs[k] = Unbounded_Cost;
+		}
+		return 0;
+	}
+
+private:
+	/** \brief Ϊ˺ */
+	static void Quantize(const float32& alpha, const float32& t_col, const float32& t_grad, PMSCostKernelArgsFixed& args)
+	{
+		const float32 frac_one = static_cast<float32>(1 << Fixed_Frac_Bits);
+		const auto to_q16 = [](const float32& v) {
+			return static_cast<uint16>(std::min(std::max(lround(v * 65536.0f), 0L), 65535L));
+		};
+		const auto to_q5 = [frac_one](const float32& v) {
+			return static_cast<sint16>(std::min(std::max(lround(v * frac_one), 0L), 32767L));
+		};
+		args.alpha_col = to_q16(1 - alpha);
+		args.alpha_grad = to_q16(alpha);
+		args.tau_col = to_q5(t_col);
+		args.tau_grad = to_q5(t_grad);
+		args.out_cost = static_cast<sint16>(((args.tau_col * args.alpha_col) >> 16) + ((args.tau_grad * args.alpha_grad) >> 16));
+		args.punish = to_q5(COST_PUNISH);
+	}
+
+	/** \brief SIMDǷзͨѡ˺ */
+	void UpdateKernel()
+	{
+		kernel_ = kernel_args_.left[0] != nullptr ? pms_simd::GetCostKernelFixed(simd_level_, patch_size_) : nullptr;
+	}
+
+	/** \brief ȨֵұС3ͨɫֵΪ765 */
+	static constexpr sint32 Weight_Lut_Size = 766;
+
+	/** \brief Ӱݶ */
+	const PGradient* grad_left_;
+	/** \brief Ӱݶ */
+	const PGradient* grad_right_;
+
+	/** \brief ɫȨֵĲұ */
+	Weight weight_lut_[Weight_Lut_Size];
+
+	/** \brief ڲ */
+	sint32 sample_step_;
+	/** \brief ʹõSIMD */
+	sint32 simd_level_;
+	/** \brief ˺ */
+	PMSCostKernelArgsFixed kernel_args_;
+	/** \brief ˺Ϊnullptrʱ޷ۺϴ */
+	PMSCostKernelFixed kernel_;
 };
 
 // ڴͨķʽʵʵֵĴۼ
@@ -137,6 +137,23 @@ int main(int argv, char** argc)
 	tt = duration_cast<std::chrono::milliseconds>(end - start);
 	printf("Done! Timing : %lf s\n", tt.count() / 1000.0);
 
+	// ׶κʱ
+	const auto& stats = pms.GetStatistics();
+	printf("  init %.1lf ms, gray %.1lf ms, gradient %.1lf ms, planar %.1lf ms, cost init %.1lf ms\n",
+		stats.time_init, stats.time_gray, stats.time_gradient, stats.time_planar, stats.time_cost_init);
+	for (size_t k = 0; k < stats.time_iter_left.size(); k++) {
+		printf("  iteration %d : left %.1lf ms, right %.1lf ms, active %.2lf%%, changed %.2lf%%, cost %.4g\n", int(k), stats.time_iter_left[k], stats.time_iter_right[k],
+			100.0 * stats.iter_active_ratio[k], 100.0 * stats.iter_changed_ratio[k], stats.iter_cost[k + 1]);
+	}
+	printf("  plane to disparity %.1lf ms, lr check %.1lf ms, fill holes %.1lf ms\n",
+		stats.time_plane_to_disp, stats.time_lr_check, stats.time_fill_holes);
+	for (sint32 view = 0; view < 2; view++) {
+		const auto& c = (view == 0) ? stats.counters_left : stats.counters_right;
+		printf("  %s view : ComputeA %llu, samples %llu, updates spatial %llu / view %llu / refine %llu\n",
+			view == 0 ? "left" : "right", (unsigned long long)c.num_compute_a, (unsigned long long)c.num_samples,
+			(unsigned long long)c.num_spatial_updates, (unsigned long long)c.num_view_updates, (unsigned long long)c.num_refine_updates);
+	}
+
 #if 0
 	// ʾݶͼ
 	cv::Mat grad_left_x = cv::Mat(height, width, CV_8UC1);
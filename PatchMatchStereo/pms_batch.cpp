@@ -0,0 +1,101 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_batch
+*/
+
+#include "stdafx.h"
+#include "pms_batch.h"
+#include <algorithm>
+#include "pms_util.h"
+
+PMSBatchMatcher::PMSBatchMatcher(): num_threads_(0), is_initialized_(false)
+{
+}
+
+PMSBatchMatcher::~PMSBatchMatcher()
+{
+	Release();
+}
+
+bool PMSBatchMatcher::Initialize(const sint32& width, const sint32& height, const PMSOption& option, const sint32& num_workers)
+{
+	Release();
+
+	option_ = option;
+	num_threads_ = pms_util::GetNumThreads(option.num_threads);
+	const sint32 workers = num_workers > 0 ? num_workers : num_threads_;
+
+	// ̵߳ƥʵ
+	const auto worker_option = WorkerOption(option, workers);
+	is_initialized_ = true;
+	for (sint32 i = 0; i < workers && is_initialized_; i++) {
+		auto* matcher = new PatchMatchStereo;
+		matchers_.push_back(matcher);
+		is_initialized_ = matcher->Initialize(width, height, worker_option);
+	}
+	return is_initialized_;
+}
+
+bool PMSBatchMatcher::Reset(const sint32& width, const sint32& height, const PMSOption& option)
+{
+	if (matchers_.empty()) {
+		return false;
+	}
+	option_ = option;
+	num_threads_ = pms_util::GetNumThreads(option.num_threads);
+	const auto worker_option = WorkerOption(option, num_workers());
+	is_initialized_ = true;
+	for (auto* matcher : matchers_) {
+		is_initialized_ = matcher->Reset(width, height, worker_option) && is_initialized_;
+	}
+	return is_initialized_;
+}
+
+PMSOption PMSBatchMatcher::WorkerOption(const PMSOption& option, const sint32& workers) const
+{
+	auto worker_option = option;
+	worker_option.num_threads = std::max(num_threads_ / std::max(workers, 1), 1);
+	return worker_option;
+}
+
+void PMSBatchMatcher::Release()
+{
+	for (auto*& matcher : matchers_) {
+		if (matcher) {
+			delete matcher;
+			matcher = nullptr;
+		}
+	}
+	matchers_.clear();
+	is_initialized_ = false;
+}
+
+bool PMSBatchMatcher::Match(const vector<PMSPair>& pairs, vector<bool>* results)
+{
+	if (results) {
+		results->assign(pairs.size(), false);
+	}
+	if (!is_initialized_) {
+		return false;
+	}
+
+	// ̶̬߳ȡԣʹøԵƥʵ
+	vector<char> status(pairs.size(), 0);
+	const sint32 num_pairs = static_cast<sint32>(pairs.size());
+	pms_util::ParallelFor(0, num_pairs, num_workers(), [&](const sint32& i, const sint32& tid) {
+		const auto& item = pairs[i];
+		// ԻأͬһʵһԵӲƽ棬Ƶģʽ±ǰһ֡
+		matchers_[tid]->ClearTemporalState();
+		status[i] = matchers_[tid]->Match(item.img_left, item.img_right, item.disp_left) ? 1 : 0;
+	});
+
+	bool is_all_success = true;
+	for (sint32 i = 0; i < num_pairs; i++) {
+		if (results) {
+			(*results)[i] = status[i] != 0;
+		}
+		is_all_success = is_all_success && status[i] != 0;
+	}
+	return is_all_success;
+}
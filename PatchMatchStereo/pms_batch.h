@@ -0,0 +1,90 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_batch
+*/
+
+#ifndef PATCH_MATCH_STEREO_BATCH_H_
+#define PATCH_MATCH_STEREO_BATCH_H_
+#include "pms_types.h"
+#include "PatchMatchStereo.h"
+
+/** \brief ƥ */
+struct PMSPair {
+	const uint8* img_left;		// Ӱָ룬3ͨ
+	const uint8* img_right;		// Ӱָ룬3ͨ
+	float32* disp_left;			// ӰӲͼָ룬ԤȷӰȳߴڴռ
+	PMSPair() : img_left(nullptr), img_right(nullptr), disp_left(nullptr) {}
+	PMSPair(const uint8* _img_left, const uint8* _img_right, float32* _disp_left) :
+		img_left(_img_left), img_right(_img_right), disp_left(_disp_left) {}
+};
+
+/**
+ * \brief ƥ
+ * ڴͬߴԵƥ䣺ÿ̳߳һƥʵʵڴڳʼʱһη䣬˺ֱӸ
+ * ڹ߳ϲƥ䣬ʣ߳ƽʵڲĲм
+ */
+class PMSBatchMatcher {
+public:
+	PMSBatchMatcher();
+	~PMSBatchMatcher();
+
+	PMSBatchMatcher(const PMSBatchMatcher&) = delete;
+	PMSBatchMatcher& operator=(const PMSBatchMatcher&) = delete;
+
+	/**
+	 * \brief ʼ
+	 * \param width			룬Ӱ
+	 * \param height			룬Ӱ
+	 * \param option			룬㷨num_threadsΪ߳
+	 * \param num_workers	룬ƥ<=0ʱȡ߳
+	 * \return Ƿɹ
+	 */
+	bool Initialize(const sint32& width, const sint32& height, const PMSOption& option, const sint32& num_workers = 0);
+
+	/**
+	 * \brief 裬ߴ缰ڴ沼ֲʱʵѷڴ
+	 * \param width			룬Ӱ
+	 * \param height			룬Ӱ
+	 * \param option			룬㷨
+	 * \return Ƿɹ
+	 */
+	bool Reset(const sint32& width, const sint32& height, const PMSOption& option);
+
+	/**
+	 * \brief ƥ
+	 * \param pairs			룬б
+	 * \param results		ǷƥɹΪnullptr
+	 * \return Ƿȫɹ
+	 */
+	bool Match(const vector<PMSPair>& pairs, vector<bool>* results = nullptr);
+
+	/** \brief ƥ */
+	inline sint32 num_workers() const { return static_cast<sint32>(matchers_.size()); }
+
+private:
+	/** \brief ڴͷ */
+	void Release();
+
+	/**
+	 * \brief ȡʵĲ߳Ϊ߳ڹ̼߳ľ
+	 * \param option		㷨
+	 * \param workers		߳
+	 */
+	PMSOption WorkerOption(const PMSOption& option, const sint32& workers) const;
+
+private:
+	/** \brief PMS */
+	PMSOption option_;
+
+	/** \brief ߳ */
+	sint32 num_threads_;
+
+	/** \brief ̵߳ƥʵ */
+	vector<PatchMatchStereo*> matchers_;
+
+	/** \brief Ƿʼ־ */
+	bool is_initialized_;
+};
+
+#endif
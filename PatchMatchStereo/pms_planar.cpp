@@ -0,0 +1,148 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_planar
+*/
+
+#include "stdafx.h"
+#include "pms_planar.h"
+#include "pms_util.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/** \brief ڴֽ */
+constexpr sint32 Planar_Align = 32;
+
+PlanarImage::PlanarImage(): width_(0), height_(0), pad_(0), stride_(0), is_fixed_(false), factor_(1), buffer_(nullptr), origins_()
+{
+}
+
+PlanarImage::~PlanarImage()
+{
+	Release();
+}
+
+bool PlanarImage::Create(const sint32& width, const sint32& height, const sint32& pad, const bool& is_fixed, const sint32& factor)
+{
+	if (width <= 0 || height <= 0 || pad < 0 || factor < 1 || (is_fixed && factor > 1)) {
+		return false;
+	}
+	// ߴͬʱڴ
+	const sint32 pad_aligned = std::max((pad + 15) / 16 * 16, 16);
+	if (buffer_ && width == width_ && height == height_ && pad_aligned == pad_ && is_fixed == is_fixed_ && factor == factor_) {
+		return true;
+	}
+	Release();
+
+	width_ = width;
+	height_ = height;
+	pad_ = pad_aligned;
+	is_fixed_ = is_fixed;
+	factor_ = factor;
+	// пȡ16ı֤ض
+	stride_ = ((width + 2 * pad_) * factor + 15) / 16 * 16;
+	const size_t plane_size = static_cast<size_t>(stride_) * (height + 2 * pad_);
+	const size_t elem_size = is_fixed ? sizeof(sint16) : sizeof(float32);
+
+	buffer_ = new uint8[plane_size * NUM_CHANNELS * elem_size + Planar_Align];
+	auto addr = reinterpret_cast<uintptr_t>(buffer_);
+	addr = (addr + Planar_Align - 1) / Planar_Align * Planar_Align;
+	auto* base = reinterpret_cast<uint8*>(addr);
+	for (sint32 n = 0; n < NUM_CHANNELS; n++) {
+		origins_[n] = base + (plane_size * n + static_cast<size_t>(pad_) * stride_ + pad_ * factor) * elem_size;
+	}
+	return true;
+}
+
+void PlanarImage::Release()
+{
+	SAFE_DELETE(buffer_);
+	for (auto& origin : origins_) {
+		origin = nullptr;
+	}
+	width_ = height_ = pad_ = stride_ = 0;
+	is_fixed_ = false;
+	factor_ = 1;
+}
+
+void PlanarImage::Fill(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads)
+{
+	if (!buffer_ || img_data == nullptr || grad_data == nullptr) {
+		return;
+	}
+	if (is_fixed_) {
+		FillChannels<sint16>(img_data, grad_data, num_threads);
+	}
+	else if (factor_ > 1) {
+		FillSuperSampled(img_data, grad_data, num_threads);
+	}
+	else {
+		FillChannels<float32>(img_data, grad_data, num_threads);
+	}
+}
+
+template <class T>
+void PlanarImage::FillChannels(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads)
+{
+	const sint32 width = width_;
+	const sint32 height = height_;
+	const sint32 pad = pad_;
+
+	// չı߽
+	pms_util::ParallelFor(-pad, height + pad, num_threads, [&](const sint32& y, const sint32&) {
+		const sint32 sy = std::min(std::max(y, 0), height - 1);
+		const uint8* img_row = img_data + sy * width * 3;
+		const PGradient* grad_row = grad_data + sy * width;
+		T* rows[NUM_CHANNELS];
+		for (sint32 n = 0; n < NUM_CHANNELS; n++) {
+			rows[n] = static_cast<T*>(origins_[n]) + static_cast<std::ptrdiff_t>(y) * stride_;
+		}
+		for (sint32 x = -pad; x < width + pad; x++) {
+			const sint32 sx = std::min(std::max(x, 0), width - 1);
+			rows[B][x] = img_row[3 * sx];
+			rows[G][x] = img_row[3 * sx + 1];
+			rows[R][x] = img_row[3 * sx + 2];
+			rows[GX][x] = grad_row[sx].x;
+			rows[GY][x] = grad_row[sx].y;
+		}
+	});
+}
+
+void PlanarImage::FillSuperSampled(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads)
+{
+	const sint32 width = width_;
+	const sint32 height = height_;
+	const sint32 pad = pad_;
+	const sint32 factor = factor_;
+
+	// Ĳֵϵۼʵʱֵļ㷽ʽһ
+	vector<float32> ofs(factor);
+	for (sint32 s = 0; s < factor; s++) {
+		ofs[s] = static_cast<float32>(s) / factor;
+	}
+
+	pms_util::ParallelFor(-pad, height + pad, num_threads, [&](const sint32& y, const sint32&) {
+		const sint32 sy = std::min(std::max(y, 0), height - 1);
+		const uint8* img_row = img_data + sy * width * 3;
+		const PGradient* grad_row = grad_data + sy * width;
+		float32* rows[NUM_CHANNELS];
+		for (sint32 n = 0; n < NUM_CHANNELS; n++) {
+			rows[n] = static_cast<float32*>(origins_[n]) + static_cast<std::ptrdiff_t>(y) * stride_;
+		}
+		for (sint32 x = -pad; x < width + pad; x++) {
+			const sint32 sx1 = std::min(std::max(x, 0), width - 1);
+			const sint32 sx2 = std::min(std::max(x + 1, 0), width - 1);
+			const float32 v1[NUM_CHANNELS] = { float32(img_row[3 * sx1]), float32(img_row[3 * sx1 + 1]), float32(img_row[3 * sx1 + 2]),
+				float32(grad_row[sx1].x), float32(grad_row[sx1].y) };
+			const float32 v2[NUM_CHANNELS] = { float32(img_row[3 * sx2]), float32(img_row[3 * sx2 + 1]), float32(img_row[3 * sx2 + 2]),
+				float32(grad_row[sx2].x), float32(grad_row[sx2].y) };
+			for (sint32 n = 0; n < NUM_CHANNELS; n++) {
+				float32* dst = rows[n] + x * factor;
+				for (sint32 s = 0; s < factor; s++) {
+					dst[s] = (1 - ofs[s]) * v1[n] + ofs[s] * v2[n];
+				}
+			}
+		}
+	});
+}
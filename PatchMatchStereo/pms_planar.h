@@ -0,0 +1,108 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_planar
+*/
+
+#ifndef PATCH_MATCH_STEREO_PLANAR_H_
+#define PATCH_MATCH_STEREO_PLANAR_H_
+#include "pms_types.h"
+
+/**
+ * \brief ͨӰ
+ * 3ͨɫݺݶݲΪBGRGxGyƽ棬չpadأƱ߽أ
+ * ƽΪfloat32ʽ򹩶ۼʹõint16ʽɫݶȾΪ޾ʧ
+ * ÿذ32ֽڶ룬ۼȡȡжϱ߽
+ * ɰfactorˮƽfloat32ʽxĵsΪxx+1аs/factorԲֵĽ
+ * λõɫݶȿֱӶȡʵʱֵ
+ */
+class PlanarImage {
+public:
+	/** \brief ͨ */
+	enum Channel { B = 0, G = 1, R = 2, GX = 3, GY = 4, NUM_CHANNELS = 5 };
+
+	PlanarImage();
+	~PlanarImage();
+
+	PlanarImage(const PlanarImage&) = delete;
+	PlanarImage& operator=(const PlanarImage&) = delete;
+
+	/**
+	 * \brief ڴ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param pad		߽չʵչȡΪ16ı
+	 * \param is_fixed	ǷΪint16ʽΪfloat32ʽ
+	 * \param factor	ˮƽ1Ϊ>1ʱΪfloat32ʽ
+	 * \return Ƿɹ
+	 */
+	bool Create(const sint32& width, const sint32& height, const sint32& pad, const bool& is_fixed = false, const sint32& factor = 1);
+
+	/** \brief ͷڴ */
+	void Release();
+
+	/**
+	 * \brief 3ͨɫݼݶƽ
+	 * \param img_data		ɫݣBGR
+	 * \param grad_data		ݶ
+	 * \param num_threads	߳
+	 */
+	void Fill(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads);
+
+	/**
+	 * \brief ȡͨƽ(0,0)ָ룬(x,y)λ ptr[y * stride() + x]xyȡ[-pad,size+pad)
+	 * ʱ(x,y)ĵsλ ptr[y * stride() + x * factor() + s]
+	 * \param n		ͨ
+	 * \return float32ʽƽָ룬int16ʽʱΪnullptr
+	 */
+	inline const float32* channel(const sint32& n) const { return is_fixed_ ? nullptr : static_cast<const float32*>(origins_[n]); }
+
+	/**
+	 * \brief ȡint16ʽͨƽ(0,0)ָ룬Ѱַʽͬchannel
+	 * \param n		ͨ
+	 * \return int16ʽƽָ룬float32ʽʱΪnullptr
+	 */
+	inline const sint16* channel16(const sint32& n) const { return is_fixed_ ? static_cast<const sint16*>(origins_[n]) : nullptr; }
+
+	/** \brief ǷΪint16ʽ */
+	inline bool is_fixed() const { return is_fixed_; }
+
+	/** \brief ˮƽ */
+	inline sint32 factor() const { return factor_; }
+
+	/** \brief пȣʱΪ */
+	inline sint32 stride() const { return stride_; }
+	/** \brief ߽չ */
+	inline sint32 pad() const { return pad_; }
+	/** \brief Ӱ */
+	inline sint32 width() const { return width_; }
+	/** \brief Ӱ */
+	inline sint32 height() const { return height_; }
+
+private:
+	/** \brief ƽʽTƽ */
+	template <class T>
+	void FillChannels(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads);
+
+	/** \brief ˮƽfloat32ʽƽ */
+	void FillSuperSampled(const uint8* img_data, const PGradient* grad_data, const sint32& num_threads);
+
+private:
+	/** \brief Ӱ */
+	sint32 width_;
+	sint32 height_;
+	/** \brief ߽չ */
+	sint32 pad_;
+	/** \brief п */
+	sint32 stride_;
+	/** \brief ǷΪint16ʽ */
+	bool is_fixed_;
+	/** \brief ˮƽ */
+	sint32 factor_;
+	/** \brief ԭʼڴ */
+	uint8* buffer_;
+	/** \brief ͨ(0,0)ָ */
+	void* origins_[NUM_CHANNELS];
+};
+
+#endif
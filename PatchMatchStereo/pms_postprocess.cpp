@@ -0,0 +1,282 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_postprocess
+*/
+
+#include "stdafx.h"
+#include "pms_postprocess.h"
+#include "pms_util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+/** \brief طֿ鲢ʱÿ */
+constexpr sint32 Pixel_Chunk = 256;
+
+PMSPostProcessor::PMSPostProcessor(): width_(0), height_(0), num_threads_(1), lrcheck_thres_(0.0f), median_filter_(PMS_MEDIAN_WEIGHTED), wnd_size_(0), gamma_(0.0f)
+{
+}
+
+void PMSPostProcessor::Prepare(const sint32& width, const sint32& height, const PMSOption& option)
+{
+	width_ = width;
+	height_ = height;
+	num_threads_ = pms_util::GetNumThreads(option.num_threads);
+	lrcheck_thres_ = option.lrcheck_thres;
+	median_filter_ = option.median_filter;
+	wnd_size_ = option.patch_size;
+
+	// ȨֵֻɫйأɫΪԤȼȫȡֵ
+	if (weight_lut_.empty() || gamma_ != option.gamma) {
+		gamma_ = option.gamma;
+		weight_lut_.resize(3 * 255 + 1);
+		for (sint32 dc = 0; dc <= 3 * 255; dc++) {
+			weight_lut_[dc] = exp(-dc / gamma_);
+		}
+	}
+
+	// ̵߳Ĵڻ棬ʱ·
+	if (static_cast<sint32>(wnd_scratch_.size()) < num_threads_) {
+		wnd_scratch_.resize(num_threads_);
+	}
+	for (auto& scratch : wnd_scratch_) {
+		scratch.reserve(wnd_size_ * wnd_size_);
+	}
+	if (static_cast<sint32>(joint_hists_.size()) < num_threads_) {
+		joint_hists_.resize(num_threads_);
+	}
+}
+
+void PMSPostProcessor::PlaneToDisparity(const DisparityPlane* planes, float32* disp) const
+{
+	if (planes == nullptr || disp == nullptr) {
+		return;
+	}
+	const sint32 width = width_;
+	pms_util::ParallelFor(0, height_, num_threads_, [&](const sint32& y, const sint32&) {
+		for (sint32 x = 0; x < width; x++) {
+			const sint32 p = y * width + x;
+			disp[p] = planes[p].to_disparity(x, y);
+		}
+	});
+}
+
+void PMSPostProcessor::LRCheck(float32* disp, const float32* disp_other, vector<pair<int, int>>& mismatches) const
+{
+	mismatches.clear();
+	if (disp == nullptr || disp_other == nullptr) {
+		return;
+	}
+	const sint32 width = width_;
+	const float32 threshold = lrcheck_thres_;
+
+	// ÿֻд뱾ͼͬһУв
+	pms_util::ParallelFor(0, height_, num_threads_, [&](const sint32& y, const sint32&) {
+		float32* disp_row = disp + y * width;
+		const float32* other_row = disp_other + y * width;
+		for (sint32 x = 0; x < width; x++) {
+			auto& d = disp_row[x];
+			if (d == Invalid_Float) {
+				continue;
+			}
+			// Ӳֵҵһͼ϶ӦͬأͼӲֵ෴
+			const auto col = lround(x - d);
+			if (col < 0 || col >= width || std::abs(d + other_row[col]) > threshold) {
+				d = Invalid_Float;
+			}
+		}
+	});
+
+	// ռЧأǰЧأ˳ؼʱһ
+	for (sint32 y = 0; y < height_; y++) {
+		const float32* disp_row = disp + y * width;
+		for (sint32 x = 0; x < width; x++) {
+			if (disp_row[x] == Invalid_Float) {
+				mismatches.emplace_back(x, y);
+			}
+		}
+	}
+}
+
+void PMSPostProcessor::FillHoles(const uint8* img_data, const DisparityPlane* planes, const vector<pair<int, int>>& mismatches, float32* disp)
+{
+	if (mismatches.empty() || img_data == nullptr || planes == nullptr || disp == nullptr) {
+		return;
+	}
+	const sint32 width = width_;
+	const sint32 num = static_cast<sint32>(mismatches.size());
+	results_.resize(num);
+
+	// ֻȡǰӲͼݴͳһдأɰطֿ鲢
+	const sint32 num_chunks = (num + Pixel_Chunk - 1) / Pixel_Chunk;
+	pms_util::ParallelFor(0, num_chunks, num_threads_, [&](const sint32& chunk, const sint32&) {
+		const sint32 n_end = std::min(num, (chunk + 1) * Pixel_Chunk);
+		for (sint32 n = chunk * Pixel_Chunk; n < n_end; n++) {
+			const sint32 x = mismatches[n].first;
+			const sint32 y = mismatches[n].second;
+			const float32* disp_row = disp + y * width;
+
+			// ҸѰһЧأ¼ƽ
+			sint32 num_planes = 0;
+			const DisparityPlane* nb_planes[2];
+			for (sint32 xs = x + 1; xs < width; xs++) {
+				if (disp_row[xs] != Invalid_Float) {
+					nb_planes[num_planes++] = &planes[y * width + xs];
+					break;
+				}
+			}
+			for (sint32 xs = x - 1; xs >= 0; xs--) {
+				if (disp_row[xs] != Invalid_Float) {
+					nb_planes[num_planes++] = &planes[y * width + xs];
+					break;
+				}
+			}
+
+			if (num_planes == 0) {
+				results_[n] = 0.0f;
+			}
+			else if (num_planes == 1) {
+				results_[n] = nb_planes[0]->to_disparity(x, y);
+			}
+			else {
+				// ѡСӲ
+				const auto d1 = nb_planes[0]->to_disparity(x, y);
+				const auto d2 = nb_planes[1]->to_disparity(x, y);
+				results_[n] = std::abs(d1) < std::abs(d2) ? d1 : d2;
+			}
+		}
+	});
+	for (sint32 n = 0; n < num; n++) {
+		disp[mismatches[n].second * width + mismatches[n].first] = results_[n];
+	}
+
+	// ֵ˲
+	MedianFilter(img_data, mismatches, disp);
+}
+
+void PMSPostProcessor::MedianFilter(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp)
+{
+	const sint32 width = width_;
+	switch (median_filter_) {
+	case PMS_MEDIAN_WEIGHTED_HIST:
+		WeightedMedianFilterHist(img_data, mismatches, disp);
+		break;
+	case PMS_MEDIAN_CONSTANT_TIME:
+		// ˲ļ봰ڳߴ޹أֻȡصĽ
+		median_map_.resize(static_cast<size_t>(width) * height_);
+		pms_util::MedianFilterO1(disp, &median_map_[0], width, height_, wnd_size_);
+		for (const auto& pix : mismatches) {
+			disp[pix.second * width + pix.first] = median_map_[pix.second * width + pix.first];
+		}
+		break;
+	default:
+		WeightedMedianFilter(img_data, mismatches, disp);
+		break;
+	}
+}
+
+void PMSPostProcessor::WeightedMedianFilter(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp)
+{
+	const sint32 width = width_;
+	const sint32 height = height_;
+	const sint32 wnd_size2 = wnd_size_ / 2;
+	const sint32 num = static_cast<sint32>(mismatches.size());
+	const float32* lut = &weight_lut_[0];
+	results_.resize(num);
+
+	const sint32 num_chunks = (num + Pixel_Chunk - 1) / Pixel_Chunk;
+	pms_util::ParallelFor(0, num_chunks, num_threads_, [&](const sint32& chunk, const sint32& tid) {
+		auto& disps = wnd_scratch_[tid];
+		const sint32 n_end = std::min(num, (chunk + 1) * Pixel_Chunk);
+		for (sint32 n = chunk * Pixel_Chunk; n < n_end; n++) {
+			const sint32 x = mismatches[n].first;
+			const sint32 y = mismatches[n].second;
+			const uint8* col_p = img_data + (y * width + x) * 3;
+			results_[n] = disp[y * width + x];
+
+			// ռڵĴȨӲ
+			disps.clear();
+			float32 total_w = 0.0f;
+			const sint32 y0 = std::max(y - wnd_size2, 0), y1 = std::min(y + wnd_size2, height - 1);
+			const sint32 x0 = std::max(x - wnd_size2, 0), x1 = std::min(x + wnd_size2, width - 1);
+			for (sint32 yr = y0; yr <= y1; yr++) {
+				const float32* disp_row = disp + yr * width;
+				const uint8* img_row = img_data + yr * width * 3;
+				for (sint32 xc = x0; xc <= x1; xc++) {
+					const float32 d = disp_row[xc];
+					if (d == Invalid_Float) {
+						continue;
+					}
+					const uint8* col_q = img_row + xc * 3;
+					const sint32 dc = std::abs(col_p[0] - col_q[0]) + std::abs(col_p[1] - col_q[1]) + std::abs(col_p[2] - col_q[2]);
+					const float32 w = lut[dc];
+					total_w += w;
+					disps.emplace_back(d, w);
+				}
+			}
+			if (!disps.empty()) {
+				results_[n] = SelectWeightedMedian(&disps[0], &disps[0] + disps.size(), total_w / 2);
+			}
+		}
+	});
+	for (sint32 n = 0; n < num; n++) {
+		disp[mismatches[n].second * width + mismatches[n].first] = results_[n];
+	}
+}
+
+void PMSPostProcessor::WeightedMedianFilterHist(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp)
+{
+	if (!pms_util::PrepareJointHist(img_data, disp, width_, height_, wnd_size_, &weight_lut_[0], joint_params_)) {
+		return;
+	}
+	const sint32 width = width_;
+	const sint32 num = static_cast<sint32>(mismatches.size());
+	results_.resize(num);
+
+	// зֶΣͬһеһ߳λڣֻ߳ȡ˲ǰӲͼ
+	row_starts_.clear();
+	for (sint32 n = 0; n < num; n++) {
+		if (n == 0 || mismatches[n].second != mismatches[n - 1].second) {
+			row_starts_.push_back(n);
+		}
+	}
+	row_starts_.push_back(num);
+	const sint32 num_rows = static_cast<sint32>(row_starts_.size()) - 1;
+	pms_util::ParallelFor(0, num_rows, num_threads_, [&](const sint32& row, const sint32& tid) {
+		const sint32 begin = row_starts_[row];
+		joint_hists_[tid].FilterRow(joint_params_, &mismatches[begin], row_starts_[row + 1] - begin, &results_[begin]);
+	});
+	for (sint32 n = 0; n < num; n++) {
+		disp[mismatches[n].second * width + mismatches[n].first] = results_[n];
+	}
+}
+
+float32 PMSPostProcessor::SelectWeightedMedian(pair<float32, float32>* first, pair<float32, float32>* last, const float32& half)
+{
+	// [first,last)֮ǰӲ򣩵ۻȨֵaccСhalfֵ[first,last)
+	float32 acc = 0.0f;
+	while (last - first > 1) {
+		auto* mid = first + (last - first) / 2;
+		std::nth_element(first, mid, last);
+		float32 w_lower = 0.0f;
+		for (auto* it = first; it < mid; ++it) {
+			w_lower += it->second;
+		}
+		if (acc + w_lower >= half) {
+			last = mid;
+		}
+		else if (acc + w_lower + mid->second >= half) {
+			return mid->first;
+		}
+		else if (mid + 1 == last) {
+			// ۻȨֵδﵽhalfʱȡӲ
+			return mid->first;
+		}
+		else {
+			acc += w_lower + mid->second;
+			first = mid + 1;
+		}
+	}
+	return first->first;
+}
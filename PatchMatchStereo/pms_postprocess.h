@@ -0,0 +1,128 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_postprocess
+*/
+
+#ifndef PATCH_MATCH_STEREO_POSTPROCESS_H_
+#define PATCH_MATCH_STEREO_POSTPROCESS_H_
+#include "pms_types.h"
+#include "pms_util.h"
+
+/** \brief Ӳֵ˲ */
+enum PMSMedianFilter {
+	PMS_MEDIAN_WEIGHTED = 0,		// Ȩֵȷѡ
+	PMS_MEDIAN_WEIGHTED_HIST = 1,	// ڻֱͼļȨֵƣpms_util::WeightedMedianFilterHist
+	PMS_MEDIAN_CONSTANT_TIME = 2	// ʱֵȨpms_util::MedianFilterO1
+};
+
+/**
+ * \brief ƽתӲһԼ顢Ӳ估Ȩֵ˲
+ * ׶ΰл򰴴طִֿ߳У߳޹
+ * ̵߳Ĵڻ桢估˲ڶƥ֮临ãߴ粻ʱвٷڴ
+ */
+class PMSPostProcessor {
+public:
+	PMSPostProcessor();
+	~PMSPostProcessor() = default;
+
+	PMSPostProcessor(const PMSPostProcessor&) = delete;
+	PMSPostProcessor& operator=(const PMSPostProcessor&) = delete;
+
+	/**
+	 * \brief Ӱߴ缰׼̵߳Ļ棬ÿƥǰ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param option	㷨
+	 */
+	void Prepare(const sint32& width, const sint32& height, const PMSOption& option);
+
+	/**
+	 * \brief ƽתӲ
+	 * \param planes	Ӳƽ漯
+	 * \param disp		Ӳͼ
+	 */
+	void PlaneToDisparity(const DisparityPlane* planes, float32* disp) const;
+
+	/**
+	 * \brief һԼ飬һµӲΪЧ
+	 * \param disp			ͼӲͼ޸
+	 * \param disp_other	һͼӲͼ
+	 * \param mismatches	ͼӲЧؼ˳
+	 */
+	void LRCheck(float32* disp, const float32* disp_other, vector<pair<int, int>>& mismatches) const;
+
+	/**
+	 * \brief Ӳ䣺ЧصƽӲȡСߣٰеķֵ˲
+	 * \param img_data		ɫ
+	 * \param planes		Ӳƽ漯
+	 * \param mismatches	ؼ
+	 * \param disp			Ӳͼ޸
+	 */
+	void FillHoles(const uint8* img_data, const DisparityPlane* planes, const vector<pair<int, int>>& mismatches, float32* disp);
+
+private:
+	/**
+	 * \brief еķؼֵ˲
+	 * \param img_data		ɫ
+	 * \param mismatches	Ҫ˲ؼ
+	 * \param disp			Ӳͼ˲޸
+	 */
+	void MedianFilter(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp);
+
+	/**
+	 * \brief ؼȨֵ˲ؾ˲ǰӲͼȡݣ봦˳޹
+	 * \param img_data		ɫ
+	 * \param mismatches	Ҫ˲ؼ
+	 * \param disp			Ӳͼ˲޸
+	 */
+	void WeightedMedianFilter(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp);
+
+	/**
+	 * \brief ؼֱͼȨֵ˲ͬpms_util::WeightedMedianFilterHist
+	 * ؼзֶΣ̸߳Եֱͼؼ˳ʱֶ
+	 * \param img_data		ɫ
+	 * \param mismatches	Ҫ˲ؼ
+	 * \param disp			Ӳͼ˲޸
+	 */
+	void WeightedMedianFilterHist(const uint8* img_data, const vector<pair<int, int>>& mismatches, float32* disp);
+
+	/**
+	 * \brief ȨӲļȨֵӲۻȨֵ״βСhalfӲ
+	 * nth_elementζ֣ʱ䣬
+	 * \param first		ȨӲʼ
+	 * \param last		ȨӲĩβǿ
+	 * \param half		Ȩֵһ
+	 */
+	static float32 SelectWeightedMedian(pair<float32, float32>* first, pair<float32, float32>* last, const float32& half);
+
+private:
+	/** \brief Ӱ */
+	sint32 width_;
+	sint32 height_;
+	/** \brief ߳ */
+	sint32 num_threads_;
+	/** \brief һֵ */
+	float32 lrcheck_thres_;
+	/** \brief ֵ˲PMSMedianFilter */
+	sint32 median_filter_;
+	/** \brief ֵ˲ڳߴ */
+	sint32 wnd_size_;
+	/** \brief ȨֵұӦgamma */
+	float32 gamma_;
+	/** \brief ɫͨԲ֮ͣ0~765Ȩֵexp(-dc/gamma)Ĳұ */
+	vector<float32> weight_lut_;
+	/** \brief ̵߳ĴȨӲڻ */
+	vector<vector<pair<float32, float32>>> wnd_scratch_;
+	/** \brief ֱͼȨֵĹ̵ֱ߳ͼ */
+	pms_util::JointHistParams joint_params_;
+	vector<pms_util::JointHistogram> joint_hists_;
+	/** \brief ؼиеʼţĩβΪ */
+	vector<sint32> row_starts_;
+	/** \brief صӲ˲ */
+	vector<float32> results_;
+	/** \brief ʱֵ˲ */
+	vector<float32> median_map_;
+};
+
+#endif
@@ -6,39 +6,56 @@
 
 #include "stdafx.h"
 #include "pms_propagation.h"
+#include "pms_util.h"
+#include "pms_random.hpp"
 
-PMSPropagation::PMSPropagation(const sint32 width, const sint32 height, const uint8* img_left, const uint8* img_right,
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::PMSPropagationT(const sint32 width, const sint32 height, const uint8* img_left, const uint8* img_right,
 	const PGradient* grad_left, const PGradient* grad_right,
 	DisparityPlane* plane_left, DisparityPlane* plane_right,
 	const PMSOption& option, 
 	float32* cost_left, float32* cost_right,
-	float32* disparity_map)
+	float32* disparity_map,
+	const PlanarImage* planar_left, const PlanarImage* planar_right,
+	const PlanarImage* planar_left_sub, const PlanarImage* planar_right_sub)
 	: cost_cpt_left_(nullptr), cost_cpt_right_(nullptr),
-	  width_(width), height_(height), num_iter_(0),
+	  width_(width), height_(height), patch_size_(PATCH > 0 ? PATCH : option.patch_size), num_iter_(0), num_threads_(pms_util::GetNumThreads(option.num_threads)),
 	  img_left_(img_left), img_right_(img_right),
 	  grad_left_(grad_left), grad_right_(grad_right),
 	  plane_left_(plane_left), plane_right_(plane_right),
 	  cost_left_(cost_left), cost_right_(cost_right),
-	  disparity_map_(disparity_map)
+	  locks_left_(nullptr), locks_right_(nullptr), stamps_left_(nullptr), stamps_right_(nullptr),
+	  prefetch_rows_(0), disparity_map_(disparity_map)
 {
 	// ۼ
-	cost_cpt_left_ = new CostComputerPMS(img_left, img_right, grad_left, grad_right, width, height,
+	auto* cost_cpt_left = new CostCpt(img_left, img_right, grad_left, grad_right, width, height,
 	                                option.patch_size, option.min_disparity, option.max_disparity, option.gamma,
 	                                option.alpha, option.tau_col, option.tau_grad);
-	cost_cpt_right_ = new CostComputerPMS(img_right, img_left, grad_right, grad_left, width, height,
+	auto* cost_cpt_right = new CostCpt(img_right, img_left, grad_right, grad_left, width, height,
 									option.patch_size, -option.max_disparity, -option.min_disparity, option.gamma,
 									option.alpha, option.tau_col, option.tau_grad);
+	cost_cpt_left->SetSimdLevel(option.simd_level);
+	cost_cpt_right->SetSimdLevel(option.simd_level);
+	cost_cpt_left->SetSampleStep(option.sample_step);
+	cost_cpt_right->SetSampleStep(option.sample_step);
+	cost_cpt_left->SetPlanarImages(planar_left, planar_right, planar_right_sub);
+	cost_cpt_right->SetPlanarImages(planar_right, planar_left, planar_left_sub);
+	cost_cpt_left_ = cost_cpt_left;
+	cost_cpt_right_ = cost_cpt_right;
 	option_ = option;
 
-	// 
-	rand_disp_ = new std::uniform_real_distribution<float32>(-1.0f, 1.0f);
-	rand_norm_ = new std::uniform_real_distribution<float32>(-1.0f, 1.0f);
+	// Ȩֵ棬ǰ벿ΪpĴȨֵ벿ֹͼqĴȨֵ
+	weights_.assign(num_threads_, vector<Weight>(2 * CostCpt::WeightsSize(patch_size_)));
+
+	// ̵߳ļ
+	counters_.assign(num_threads_, PMSCounters());
 
 	// ʼ
 	ComputeCostData();
 }
 
-PMSPropagation::~PMSPropagation()
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::~PMSPropagationT()
 {
 	if(cost_cpt_left_) {
 		delete cost_cpt_left_;
@@ -48,42 +65,129 @@ PMSPropagation::~PMSPropagation()
 		delete cost_cpt_right_;
 		cost_cpt_right_ = nullptr;
 	}
-	if (rand_disp_) {
-		delete rand_disp_;
-		rand_disp_ = nullptr;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::SetPlaneLocks(PlaneLocks* locks_left, PlaneLocks* locks_right)
+{
+	locks_left_ = locks_left;
+	locks_right_ = locks_right;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::SetPixelStamps(PixelStamps* stamps_left, PixelStamps* stamps_right)
+{
+	stamps_left_ = stamps_left;
+	stamps_right_ = stamps_right;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+PMSCounters PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::GetCounters() const
+{
+	PMSCounters counters;
+	for (const auto& c : counters_) {
+		counters += c;
 	}
-	if (rand_norm_) {
-		delete rand_norm_;
-		rand_norm_ = nullptr;
+	return counters;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::SetRowPrefetch(const std::function<void(const sint32&, const sint32&)>& prefetch, const sint32& band_rows)
+{
+	prefetch_ = prefetch;
+	prefetch_rows_ = std::max(band_rows, 1);
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::PrefetchRows(const sint32& i, const sint32& y, const sint32& dir) const
+{
+	if (!prefetch_ || i % prefetch_rows_ != 0) {
+		return;
+	}
+	// ׸дҲԤȡ
+	const sint32 band = prefetch_rows_;
+	const sint32 from = (i == 0) ? 0 : band;
+	if (dir == 1) {
+		const sint32 y0 = y + from, y1 = std::min(y + 2 * band, height_);
+		if (y0 < y1) {
+			prefetch_(y0, y1);
+		}
+	}
+	else {
+		const sint32 y0 = std::max(y - 2 * band + 1, 0), y1 = y - from + 1;
+		if (y0 < y1) {
+			prefetch_(y0, y1);
+		}
 	}
 }
 
-void PMSPropagation::DoPropagation()
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::ReadPlane(const sint32& view, const sint32& p, DisparityPlane& plane, float32& cost) const
 {
-	if(!cost_cpt_left_|| !cost_cpt_right_ || !img_left_||!img_right_||!grad_left_||!grad_right_ ||!cost_left_||!plane_left_||!plane_right_||!disparity_map_||
-		!rand_disp_||!rand_norm_) {
+	const auto* locks = (view == 0) ? locks_left_ : locks_right_;
+	const auto* planes = (view == 0) ? plane_left_ : plane_right_;
+	const auto* costs = (view == 0) ? cost_left_ : cost_right_;
+	if (locks) {
+		locks->lock(p);
+	}
+	plane = planes[p];
+	cost = costs[p];
+	if (locks) {
+		locks->unlock(p);
+	}
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+bool PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::UpdatePlane(const sint32& view, const sint32& p, const DisparityPlane& plane, const float32& cost) const
+{
+	const auto* locks = (view == 0) ? locks_left_ : locks_right_;
+	auto* planes = (view == 0) ? plane_left_ : plane_right_;
+	auto* costs = (view == 0) ? cost_left_ : cost_right_;
+	if (locks) {
+		locks->lock(p);
+	}
+	// ڼһ߳̿Ѹ¸أ뵱ǰ±Ƚ
+	const bool is_update = cost < costs[p];
+	if (is_update) {
+		// ½ﵽֵʱ¼ڵĵ΢СĸĽټ
+		// ͼĵͬһͼ䱾εмɿñ
+		const auto* stamps = (view == 0) ? stamps_left_ : stamps_right_;
+		if (stamps && cost < costs[p] * (1.0f - option_.active_thres)) {
+			stamps->set(p, num_iter_ + 1);
+		}
+		planes[p] = plane;
+		costs[p] = cost;
+	}
+	if (locks) {
+		locks->unlock(p);
+	}
+	return is_update;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::DoPropagation()
+{
+	if(!cost_cpt_left_|| !cost_cpt_right_ || !img_left_||!img_right_||!grad_left_||!grad_right_ ||!cost_left_||!plane_left_||!plane_right_||!disparity_map_) {
+		return;
+	}
+
+	// ̸д
+	if (option_.is_redblack_propagation) {
+		DoPropagationRedBlack();
 		return;
 	}
 
 	// żεϵ´
 	// εµϴ
 	const sint32 dir = (num_iter_%2==0) ? 1 : -1;
+	Weight* weights = &weights_[0][0];
+	auto& counters = counters_[0];
 	sint32 y = (dir == 1) ? 0 : height_ - 1;
 	for (sint32 i = 0; i < height_; i++) {
+		PrefetchRows(i, y, dir);
 		sint32 x = (dir == 1) ? 0 : width_ - 1;
 		for (sint32 j = 0; j < width_; j++) {
-
-			// ռ䴫
-			SpatialPropagation(x, y, dir);
-
-			// ƽŻ
-			if (!option_.is_fource_fpw) {
-				PlaneRefine(x, y);
-			}
-
-			// ͼ
-			ViewPropagation(x, y);
-
+			VisitPixel(x, y, dir, weights, counters);
 			x += dir;
 		}
 		y += dir;
@@ -91,63 +195,180 @@ void PMSPropagation::DoPropagation()
 	++num_iter_;
 }
 
-void PMSPropagation::ComputeCostData() const
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::ComputeCostData()
 {
-	if (!cost_cpt_left_ || !cost_cpt_right_ || !img_left_ || !img_right_ || !grad_left_ || !grad_right_ || !cost_left_ || !plane_left_ || !plane_right_ || !disparity_map_ ||
-		!rand_disp_ || !rand_norm_) {
+	if (!cost_cpt_left_ || !cost_cpt_right_ || !img_left_ || !img_right_ || !grad_left_ || !grad_right_ || !cost_left_ || !plane_left_ || !plane_right_ || !disparity_map_) {
 		return;
 	}
-	auto* cost_cpt = dynamic_cast<CostComputerPMS*>(cost_cpt_left_);
-	for (sint32 y = 0; y < height_; y++) {
+	auto* cost_cpt = cost_cpt_left_;
+	// лвм
+	pms_util::ParallelFor(0, height_, num_threads_, [&](const sint32& y, const sint32& tid) {
+		Weight* weights = &weights_[tid][0];
+		auto& counters = counters_[tid];
 		for (sint32 x = 0; x < width_; x++) {
-			const auto& plane_p = plane_left_[y * width_ + x];
-			cost_left_[y * width_ + x] = cost_cpt->ComputeA(x, y, plane_p);
+			const sint32 p = y * width_ + x;
+			cost_cpt->template ComputeWeights<PATCH>(x, y, weights);
+			counters.num_samples += cost_cpt->template ComputeA<PATCH>(x, y, &plane_left_[p], 1, weights, &cost_left_[p]);
+		}
+		counters.num_compute_a += width_;
+	});
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::DoPropagationRedBlack()
+{
+	// ذ(x+y)żΪ졢飬ɫصΪɫأ֮Ȼ
+	// ĳһʱֻȡһƽ棬ؿȫ
+	// ͼֻдһͼͬһУз̼߳ɱ֤д޾
+	// żεȺڣεȺں
+	for (sint32 phase = 0; phase < 2; phase++) {
+		const sint32 color = (num_iter_ + phase) % 2;
+		pms_util::ParallelFor(0, height_, num_threads_, [&](const sint32& y, const sint32& tid) {
+			PrefetchRows(y, y, 1);
+			Weight* weights = &weights_[tid][0];
+			auto& counters = counters_[tid];
+			for (sint32 x = (y + color) % 2; x < width_; x += 2) {
+				VisitPixel(x, y, 0, weights, counters);
+			}
+		});
+	}
+	++num_iter_;
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::VisitPixel(const sint32& x, const sint32& y, const sint32& direction, Weight* weights, PMSCounters& counters) const
+{
+	// pѡƽδ仯ʱռ䴫ͼĽϴηֱֻͬ
+	bool is_refine = !FPW;
+	if (stamps_left_) {
+		if (!IsActive(x, y, direction)) {
+			return;
+		}
+		// pƽϴεʼδ仯仯ʣʱƽŻִ
+		if (stamps_left_->get(y * width_ + x) < num_iter_ && (num_iter_ + x + y) % 2 != 0) {
+			is_refine = false;
+		}
+	}
+	counters.num_visited_pixels++;
+
+	// 㴰Ȩֵ
+	cost_cpt_left_->template ComputeWeights<PATCH>(x, y, weights);
+
+	// ռ䴫
+	bool is_changed = SpatialPropagation(x, y, direction, weights, counters);
+
+	// ƽŻ
+	if (is_refine) {
+		is_changed |= PlaneRefine(x, y, weights, counters);
+	}
+	counters.num_changed_pixels += is_changed;
+
+	// ͼ
+	ViewPropagation(x, y, weights + CostCpt::WeightsSize(patch_size_), counters);
+}
+
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+bool PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::IsActive(const sint32& x, const sint32& y, const sint32& direction) const
+{
+	// ǲСڵǰʾƽϴε򱾴εб£״εʱؾ㣩
+	const auto* stamps = stamps_left_;
+	const sint32 p = y * width_ + x;
+	if (stamps->get(p) >= num_iter_) {
+		return true;
+	}
+	// ˳򴫲ʱһͼͼp֮Ÿ´ɨ跽෴ʱΪѡ
+	// ڴʱΪ15ĺѡSpatialPropagationһ
+	const auto changed = [&](const sint32& xd, const sint32& yd) {
+		return xd >= 0 && xd < width_ && yd >= 0 && yd < height_ && stamps->get(yd * width_ + xd) >= num_iter_;
+	};
+	for (const sint32 dist : { 1, 5 }) {
+		if (changed(x - dist, y) || changed(x + dist, y) || changed(x, y - dist) || changed(x, y + dist)) {
+			return true;
+		}
+		if (direction != 0) {
+			break;
 		}
 	}
+	return false;
 }
 
-void PMSPropagation::SpatialPropagation(const sint32& x, const sint32& y, const sint32& direction) const
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+bool PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::SpatialPropagation(const sint32& x, const sint32& y, const sint32& direction, const Weight* weights, PMSCounters& counters) const
 {
 	// ---
 	// ռ䴫
 
 	// żεϵ´
 	// εµϴ
+	// ڴdirectionΪ0ʱȡ
 	const sint32 dir = direction;
 
-	// ȡpǰӲƽ沢
-	auto& plane_p = plane_left_[y * width_ + x];
-	auto& cost_p = cost_left_[y * width_ + x];
-	auto* cost_cpt = dynamic_cast<CostComputerPMS*>(cost_cpt_left_);
-
-	// ȡp()صӲƽ棬㽫ƽpʱĴۣȡСֵ
-	const sint32 xd = x - dir;
-	if (xd >= 0 && xd < width_) {
-		auto& plane = plane_left_[y * width_ + xd];
-		if (plane != plane_p) {
-			const auto cost = cost_cpt->ComputeA(x, y, plane);
-			if (cost < cost_p) {
-				plane_p = plane;
-				cost_p = cost;
-			}
+	// ȡpǰӲƽ漰
+	const sint32 p = y * width_ + x;
+	DisparityPlane plane_p;
+	float32 cost_p;
+	ReadPlane(0, p, plane_p, cost_p);
+	auto* cost_cpt = cost_cpt_left_;
+
+	// ѡأ˳򴫲ʱΪ()()
+	// ڴʱȡҾΪ15أΪһɫԶֲδ̵Ĳ
+	sint32 num_nbs = 0;
+	sint32 nbs[8][2];
+	if (dir != 0) {
+		nbs[0][0] = x - dir; nbs[0][1] = y;
+		nbs[1][0] = x; nbs[1][1] = y - dir;
+		num_nbs = 2;
+	}
+	else {
+		for (const sint32 dist : { 1, 5 }) {
+			nbs[num_nbs][0] = x - dist; nbs[num_nbs++][1] = y;
+			nbs[num_nbs][0] = x + dist; nbs[num_nbs++][1] = y;
+			nbs[num_nbs][0] = x; nbs[num_nbs++][1] = y - dist;
+			nbs[num_nbs][0] = x; nbs[num_nbs++][1] = y + dist;
 		}
 	}
 
-	// ȡp()صӲƽ棬㽫ƽpʱĴۣȡСֵ
-	const sint32 yd = y - dir;
-	if (yd >= 0 && yd < height_) {
-		auto& plane = plane_left_[yd * width_ + x];
-		if (plane != plane_p) {
-			const auto cost = cost_cpt->ComputeA(x, y, plane);
-			if (cost < cost_p) {
-				plane_p = plane;
-				cost_p = cost;
-			}
+	// ȡصӲƽΪѡƽ
+	sint32 num_cands = 0;
+	DisparityPlane cands[8];
+	for (sint32 n = 0; n < num_nbs; n++) {
+		const sint32 xd = nbs[n][0];
+		const sint32 yd = nbs[n][1];
+		if (xd < 0 || xd >= width_ || yd < 0 || yd >= height_) {
+			continue;
 		}
+		float32 cost_nb;
+		ReadPlane(0, yd * width_ + xd, cands[num_cands], cost_nb);
+		if (cands[num_cands] != plane_p) {
+			num_cands++;
+		}
+	}
+	if (num_cands == 0) {
+		return false;
 	}
+
+	// 㽫ѡƽpʱĴۣȡСֵ
+	// pĵǰΪޣֺͳ޵ĺѡƽǰֹͣۼ
+	float32 costs[8];
+	counters.num_samples += cost_cpt->template ComputeABounded<PATCH>(x, y, cands, num_cands, weights, cost_p, costs);
+	counters.num_compute_a += num_cands;
+	sint32 best = -1;
+	for (sint32 n = 0; n < num_cands; n++) {
+		if (costs[n] < cost_p) {
+			cost_p = costs[n];
+			best = n;
+		}
+	}
+	if (best >= 0 && UpdatePlane(0, p, cands[best], cost_p)) {
+		counters.num_spatial_updates++;
+		return true;
+	}
+	return false;
 }
 
-void PMSPropagation::ViewPropagation(const sint32& x, const sint32& y) const
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+void PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::ViewPropagation(const sint32& x, const sint32& y, Weight* weights, PMSCounters& counters) const
 {
 	// --
 	// ͼ
@@ -155,8 +376,10 @@ void PMSPropagation::ViewPropagation(const sint32& x, const sint32& y) const
 
 	// ͼƥpλüӲƽ 
 	const sint32 p = y * width_ + x;
-	const auto& plane_p = plane_left_[p];
-	auto* cost_cpt = dynamic_cast<CostComputerPMS*>(cost_cpt_right_);
+	DisparityPlane plane_p;
+	float32 cost_p;
+	ReadPlane(0, p, plane_p, cost_p);
+	auto* cost_cpt = cost_cpt_right_;
 
 	const float32 d_p = plane_p.to_disparity(x, y);
 
@@ -167,50 +390,58 @@ void PMSPropagation::ViewPropagation(const sint32& x, const sint32& y) const
 	}
 
 	const sint32 q = y * width_ + xr;
-	auto& plane_q = plane_right_[q];
-	auto& cost_q = cost_right_[q];
+	DisparityPlane plane_q;
+	float32 cost_q;
+	ReadPlane(1, q, plane_q, cost_q);
 
 	// ͼӲƽתͼ
 	const auto plane_p2q = plane_p.to_another_view(x, y);
-	const float32 d_q = plane_p2q.to_disparity(xr,y);
-	const auto cost = cost_cpt->ComputeA(xr, y, plane_p2q);
-	if (cost < cost_q) {
-		plane_q = plane_p2q;
-		cost_q = cost;
+	cost_cpt->template ComputeWeights<PATCH>(xr, y, weights);
+	float32 cost;
+	counters.num_samples += cost_cpt->template ComputeABounded<PATCH>(xr, y, &plane_p2q, 1, weights, cost_q, &cost);
+	counters.num_compute_a++;
+	if (cost < cost_q && UpdatePlane(1, q, plane_p2q, cost)) {
+		counters.num_view_updates++;
 	}
 }
 
-void PMSPropagation::PlaneRefine(const sint32& x, const sint32& y) const
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+bool PMSPropagationT<CostCpt, PATCH, FPW, INT_DISP>::PlaneRefine(const sint32& x, const sint32& y, const Weight* weights, PMSCounters& counters) const
 {
 	// --
 	// ƽŻ
 	const auto max_disp = static_cast<float32>(option_.max_disparity);
 	const auto min_disp = static_cast<float32>(option_.min_disparity);
 
-	// 
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	const auto& rand_d = *rand_disp_;
-	const auto& rand_n= *rand_norm_;
-
 	// pƽ桢ۡӲ
-	auto& plane_p = plane_left_[y * width_ + x];
-	auto& cost_p = cost_left_[y * width_ + x];
-	auto* cost_cpt = dynamic_cast<CostComputerPMS*>(cost_cpt_left_);
+	const sint32 p = y * width_ + x;
+	DisparityPlane plane_p;
+	float32 cost_p;
+	ReadPlane(0, p, plane_p, cost_p);
+	auto* cost_cpt = cost_cpt_left_;
+
+	// ԵΪ߳˳޹
+	PMSRandom rng(option_.seed, num_iter_, p);
 
 	float32 d_p = plane_p.to_disparity(x, y);
 	PVector3f norm_p = plane_p.to_normal();
 
 	float32 disp_update = (max_disp - min_disp) / 2.0f;
 	float32 norm_update = 1.0f;
+	if (option_.refine_range > 0.0f && option_.refine_range < disp_update) {
+		// СŻΧŶΧͬС
+		norm_update = option_.refine_range / disp_update;
+		disp_update = option_.refine_range;
+	}
 	const float32 stop_thres = 0.1f;
 
-	// Ż
+	// СŶΧÿŶĿǰŵƽΪģ۽ʱ
+	bool is_improved = false;
 	while (disp_update > stop_thres) {
 
 		//  -disp_update ~ disp_update ΧһӲ
-		float32 disp_rd = rand_d(gen) * disp_update;
-		if (option_.is_integer_disp) {
+		float32 disp_rd = rng.Uniform(-1.0f, 1.0f) * disp_update;
+		if (INT_DISP) {
 			disp_rd = static_cast<float32>(round(disp_rd));
 		}
 
@@ -224,12 +455,12 @@ void PMSPropagation::PlaneRefine(const sint32& x, const sint32& y) const
 
 		//  -norm_update ~ norm_update ΧֵΪ
 		PVector3f norm_rd;
-		if (!option_.is_fource_fpw) {
-			norm_rd.x = rand_n(gen) * norm_update;
-			norm_rd.y = rand_n(gen) * norm_update;
-			float32 z = rand_n(gen) * norm_update;
+		if (!FPW) {
+			norm_rd.x = rng.Uniform(-1.0f, 1.0f) * norm_update;
+			norm_rd.y = rng.Uniform(-1.0f, 1.0f) * norm_update;
+			float32 z = rng.Uniform(-1.0f, 1.0f) * norm_update;
 			while (z == 0.0f) {
-				z = rand_n(gen) * norm_update;
+				z = rng.Uniform(-1.0f, 1.0f) * norm_update;
 			}
 			norm_rd.z = z;
 		}
@@ -244,19 +475,80 @@ void PMSPropagation::PlaneRefine(const sint32& x, const sint32& y) const
 		// µӲƽ
 		auto plane_new = DisparityPlane(x, y, norm_p_new, d_p_new);
 
-		// ȽCost
+		// ȽCostpĵǰΪ
 		if (plane_new != plane_p) {
-			const float32 cost = cost_cpt->ComputeA(x, y, plane_new);
-
+			float32 cost;
+			counters.num_samples += cost_cpt->template ComputeABounded<PATCH>(x, y, &plane_new, 1, weights, cost_p, &cost);
+			counters.num_compute_a++;
 			if (cost < cost_p) {
 				plane_p = plane_new;
 				cost_p = cost;
 				d_p = d_p_new;
 				norm_p = norm_p_new;
+				is_improved = true;
 			}
 		}
 
 		disp_update /= 2.0f;
 		norm_update /= 2.0f;
 	}
+
+	if (is_improved && UpdatePlane(0, p, plane_p, cost_p)) {
+		counters.num_refine_updates++;
+		return true;
+	}
+	return false;
+}
+
+namespace {
+	/** \brief ģʽ־ѡػ汾 */
+	template <class CostCpt, sint32 PATCH, class... Args>
+	PMSPropagation* CreateWithFlags(const PMSOption& option, const Args&... args)
+	{
+		if (option.is_fource_fpw) {
+			if (option.is_integer_disp) {
+				return new PMSPropagationT<CostCpt, PATCH, true, true>(args...);
+			}
+			return new PMSPropagationT<CostCpt, PATCH, true, false>(args...);
+		}
+		if (option.is_integer_disp) {
+			return new PMSPropagationT<CostCpt, PATCH, false, true>(args...);
+		}
+		return new PMSPropagationT<CostCpt, PATCH, false, false>(args...);
+	}
+
+	/** \brief ڳߴѡػ汾ߴʹͨð汾 */
+	template <class CostCpt, class... Args>
+	PMSPropagation* CreateWithPatch(const PMSOption& option, const Args&... args)
+	{
+		switch (option.patch_size) {
+		case 11:
+			return CreateWithFlags<CostCpt, 11>(option, args...);
+		case 21:
+			return CreateWithFlags<CostCpt, 21>(option, args...);
+		case 35:
+			return CreateWithFlags<CostCpt, 35>(option, args...);
+		default:
+			return CreateWithFlags<CostCpt, 0>(option, args...);
+		}
+	}
+}
+
+PMSPropagation* PMSPropagation::Create(const sint32 width, const sint32 height, const uint8* img_left, const uint8* img_right,
+	const PGradient* grad_left, const PGradient* grad_right,
+	DisparityPlane* plane_left, DisparityPlane* plane_right,
+	const PMSOption& option,
+	float32* cost_left, float32* cost_right,
+	float32* disparity_map,
+	const PlanarImage* planar_left, const PlanarImage* planar_right,
+	const PlanarImage* planar_left_sub, const PlanarImage* planar_right_sub)
+{
+	// ۼҪint16ʽķͨݣȡֵΧʱʹøۼ
+	if (option.is_fixed_point && planar_left != nullptr && planar_left->is_fixed() &&
+		CostComputerPMSFixed::IsSupported(option.patch_size, option.alpha, option.tau_col, option.tau_grad)) {
+		return CreateWithPatch<CostComputerPMSFixed>(option, width, height, img_left, img_right, grad_left, grad_right,
+			plane_left, plane_right, option, cost_left, cost_right, disparity_map, planar_left, planar_right, planar_left_sub, planar_right_sub);
+	}
+	return CreateWithPatch<CostComputerPMS>(option, width, height, img_left, img_right, grad_left, grad_right,
+		plane_left, plane_right, option, cost_left, cost_right, disparity_map, planar_left, planar_right, planar_left_sub, planar_right_sub);
 }
@@ -7,58 +7,201 @@
 #ifndef PATCH_MATCH_STEREO_PROPAGATION_H_
 #define PATCH_MATCH_STEREO_PROPAGATION_H_
 #include "pms_types.h"
+#include <functional>
 
 #include "cost_computor.hpp"
-#include <random>
+#include "pms_sync.hpp"
+
+/**
+ * \brief ӿ
+ * ʵΪPMSPropagationTۼڳߴ缰ģʽ־ڱػCreateݲѡ
+ */
+class PMSPropagation {
+public:
+	virtual ~PMSPropagation() = default;
+
+	/**
+	 * \brief ݲʵôڳߴ磨112135ǿǰƽдڡӲ־ʹñػ汾
+	 * صʵɵͷ
+	 * planar_left_sub/planar_right_subΪˮƽķͨݣʱۼжȡλõɫݶ
+	 */
+	static PMSPropagation* Create(const sint32 width, const sint32 height,
+		const uint8* img_left, const uint8* img_right,
+		const PGradient* grad_left, const PGradient* grad_right,
+		DisparityPlane* plane_left, DisparityPlane* plane_right,
+		const PMSOption& option,
+		float32* cost_left, float32* cost_right,
+		float32* disparity_map,
+		const PlanarImage* planar_left = nullptr, const PlanarImage* planar_right = nullptr,
+		const PlanarImage* planar_left_sub = nullptr, const PlanarImage* planar_right_sub = nullptr);
+
+	/** \brief ִдһ */
+	virtual void DoPropagation() = 0;
+
+	/**
+	 * \brief ƽͼʱʹãΪnullptrʱдƽ治
+	 * \param locks_left	ͼƽ
+	 * \param locks_right	һͼƽ
+	 */
+	virtual void SetPlaneLocks(PlaneLocks* locks_left, PlaneLocks* locks_right) = 0;
+
+	/**
+	 * \brief Ԥȡɨ跽ÿһдʱ֪ͨԤȡһдƽ漰
+	 * \param prefetch		ԤȡΪ[y_begin,y_end)ܱ߳ͬʱ
+	 * \param band_rows		д
+	 */
+	virtual void SetRowPrefetch(const std::function<void(const sint32&, const sint32&)>& prefetch, const sint32& band_rows) = 0;
+
+	/**
+	 * \brief ر仯ǣΪnullptrʱÿε
+	 * \param stamps_left	ͼ仯
+	 * \param stamps_right	һͼ仯
+	 */
+	virtual void SetPixelStamps(PixelStamps* stamps_left, PixelStamps* stamps_right) = 0;
+
+	/** \brief ȡԴۼƼʼۼ㣩ڴ */
+	virtual PMSCounters GetCounters() const = 0;
+};
 
 /**
  * \brief 
+ * \tparam CostCpt		ۼ
+ * \tparam PATCH		ڳߴ磬Ϊ0ʱʹòеpatch_size
+ * \tparam FPW			ǷǿΪǰƽд
+ * \tparam INT_DISP		ǷΪӲ
  */
-class PMSPropagation final{
+template <class CostCpt, sint32 PATCH, bool FPW, bool INT_DISP>
+class PMSPropagationT final : public PMSPropagation {
 public:
-	PMSPropagation(const sint32 width, const sint32 height,
+	/** \brief Ȩֵͣɴۼ */
+	typedef typename CostCpt::Weight Weight;
+
+	PMSPropagationT(const sint32 width, const sint32 height,
 		const uint8* img_left, const uint8* img_right,
 		const PGradient* grad_left, const PGradient* grad_right,
 		DisparityPlane* plane_left, DisparityPlane* plane_right,
 		const PMSOption& option,
 		float32* cost_left, float32* cost_right,
-		float32* disparity_map);
+		float32* disparity_map,
+		const PlanarImage* planar_left, const PlanarImage* planar_right,
+		const PlanarImage* planar_left_sub, const PlanarImage* planar_right_sub);
 
-	~PMSPropagation();
+	~PMSPropagationT() override;
 
 public:
 	/** \brief ִдһ */
-	void DoPropagation();
+	void DoPropagation() override;
+
+	/**
+	 * \brief ƽͼʱʹãΪnullptrʱдƽ治
+	 * \param locks_left	ͼƽ
+	 * \param locks_right	һͼƽ
+	 */
+	void SetPlaneLocks(PlaneLocks* locks_left, PlaneLocks* locks_right) override;
+
+	/**
+	 * \brief Ԥȡɨ跽ÿһдʱ֪ͨԤȡһдƽ漰
+	 * \param prefetch		ԤȡΪ[y_begin,y_end)ܱ߳ͬʱ
+	 * \param band_rows		д
+	 */
+	void SetRowPrefetch(const std::function<void(const sint32&, const sint32&)>& prefetch, const sint32& band_rows) override;
+
+	/**
+	 * \brief ر仯ǣΪnullptrʱÿε
+	 * \param stamps_left	ͼ仯
+	 * \param stamps_right	һͼ仯
+	 */
+	void SetPixelStamps(PixelStamps* stamps_left, PixelStamps* stamps_right) override;
+
+	/** \brief ȡԴۼƼʼۼ㣩ڴ */
+	PMSCounters GetCounters() const override;
 
 private:
 	/** \brief  */
-	void ComputeCostData() const;
+	void ComputeCostData();
+
+	/** \brief ̸дһΣͬɫ֮以ɶ̲߳д */
+	void DoPropagationRedBlack();
+
+	/**
+	 * \brief pռ䴫ƽŻͼ
+	 * ʱpѡƽϴεʼδppƽδ仯ʱŻ
+	 * \param x x
+	 * \param y y
+	 * \param direction ͬSpatialPropagation
+	 * \param weights Ȩֵ
+	 * \param counters ǰ̵߳ļ
+	 */
+	void VisitPixel(const sint32& x, const sint32& y, const sint32& direction, Weight* weights, PMSCounters& counters) const;
+
+	/**
+	 * \brief ʱжpǷҪʣpѡƽϴεʼ󱻸¹
+	 * \param x x
+	 * \param y y
+	 * \param direction ͬSpatialPropagation
+	 */
+	bool IsActive(const sint32& x, const sint32& y, const sint32& direction) const;
 
 	/**
 	 * \brief ռ䴫
 	 * \param x x
 	 * \param y y
-	 * \param direction 
+	 * \param direction 1/-1Ϊ˳򴫲0Ϊڴȡ
+	 * \param weights صĴȨֵ
+	 * \param counters ǰ̵߳ļ
+	 * \return pƽǷ񱻸
 	 */
-	void SpatialPropagation(const sint32& x, const sint32& y, const sint32& direction) const;
+	bool SpatialPropagation(const sint32& x, const sint32& y, const sint32& direction, const Weight* weights, PMSCounters& counters) const;
 	
 	/**
 	 * \brief ͼ
 	 * \param x x
 	 * \param y y
+	 * \param weights Ȩֵ棬ڼͬĴȨֵ
+	 * \param counters ǰ̵߳ļ
 	 */
-	void ViewPropagation(const sint32& x, const sint32& y) const;
+	void ViewPropagation(const sint32& x, const sint32& y, Weight* weights, PMSCounters& counters) const;
 	
 	/**
 	 * \brief ƽŻ
 	 * \param x x
 	 * \param y y
+	 * \param weights صĴȨֵ
+	 * \param counters ǰ̵߳ļ
+	 * \return pƽǷ񱻸
+	 */
+	bool PlaneRefine(const sint32& x, const sint32& y, const Weight* weights, PMSCounters& counters) const;
+
+	/**
+	 * \brief ȡصӲƽ漰
+	 * \param view		0-ͼ 1-һͼ
+	 * \param p			
+	 * \param plane		Ӳƽ
+	 * \param cost		
+	 */
+	void ReadPlane(const sint32& view, const sint32& p, DisparityPlane& plane, float32& cost) const;
+
+	/**
+	 * \brief ´СصĵǰۣӲƽ漰
+	 * \param view		0-ͼ 1-һͼ
+	 * \param p			
+	 * \param plane		Ӳƽ
+	 * \param cost		´
+	 * \return Ƿ
+	 */
+	bool UpdatePlane(const sint32& view, const sint32& p, const DisparityPlane& plane, const float32& cost) const;
+
+	/**
+	 * \brief ɨ赽iУкyʱΪдԤȡɨ跽ϵһд
+	 * \param i		ɨ
+	 * \param y		к
+	 * \param dir	ɨ跽1Ϊ϶£-1Ϊ¶
 	 */
-	void PlaneRefine(const sint32& x, const sint32& y) const;
+	void PrefetchRows(const sint32& i, const sint32& y, const sint32& dir) const;
 private:
 	/** \brief ۼ */
-	CostComputer* cost_cpt_left_;
-	CostComputer* cost_cpt_right_;
+	CostCpt* cost_cpt_left_;
+	CostCpt* cost_cpt_right_;
 
 	/** \brief PMS㷨*/
 	PMSOption option_;
@@ -67,9 +210,21 @@ private:
 	sint32 width_;  
 	sint32 height_;
 
+	/** \brief ڳߴ */
+	sint32 patch_size_;
+
 	/** \brief  */
 	sint32 num_iter_;
 
+	/** \brief ߳ */
+	sint32 num_threads_;
+
+	/** \brief ̵߳ĴȨֵ棬ÿηʱһΣصкѡƽ渴 */
+	vector<vector<Weight>> weights_;
+
+	/** \brief ̵߳ļ */
+	vector<PMSCounters> counters_;
+
 	/** \brief Ӱ */
 	const uint8* img_left_;
 	const uint8* img_right_;
@@ -86,12 +241,20 @@ private:
 	float32* cost_left_;
 	float32* cost_right_;
 
+	/** \brief ƽͼʱЧ */
+	PlaneLocks* locks_left_;
+	PlaneLocks* locks_right_;
+
+	/** \brief ر仯ǣʱЧ */
+	PixelStamps* stamps_left_;
+	PixelStamps* stamps_right_;
+
+	/** \brief Ԥȡд */
+	std::function<void(const sint32&, const sint32&)> prefetch_;
+	sint32 prefetch_rows_;
+
 	/** \brief Ӳ */
 	float32* disparity_map_;
-
-	/** \brief  */
-	std::uniform_real_distribution<float32>* rand_disp_;
-	std::uniform_real_distribution<float32>* rand_norm_;
 };
 
 #endif
@@ -0,0 +1,63 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of counter-based random generator
+*/
+
+#ifndef PATCH_MATCH_STEREO_RANDOM_HPP_
+#define PATCH_MATCH_STEREO_RANDOM_HPP_
+#include "pms_types.h"
+
+/**
+ * \brief ڼ
+ * (,,)ԪȷԿÿʱԿϣϵͳã޹״̬
+ * ź͵Ϊʱص߳˳޹أλ
+ * UniformRandomBitGeneratorҪҲstdеķֲʹ
+ */
+class PMSRandom {
+public:
+	typedef uint64 result_type;
+
+	/**
+	 * \brief 
+	 * \param seed		
+	 * \param stream	ͼ
+	 * \param index		ţһΪ
+	 */
+	PMSRandom(const uint64& seed, const uint64& stream, const uint64& index) : counter_(0) {
+		key_ = Mix(seed ^ Mix(stream ^ Mix(index)));
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~result_type(0); }
+
+	/** \brief һ64λ */
+	inline result_type operator()() {
+		return Mix(key_ + (++counter_) * 0x9E3779B97F4A7C15ull);
+	}
+
+	/** \brief [0,1)ȷֲ */
+	inline float32 Uniform() {
+		return static_cast<float32>((*this)() >> 40) * (1.0f / 16777216.0f);
+	}
+
+	/** \brief [lo,hi)ȷֲ */
+	inline float32 Uniform(const float32& lo, const float32& hi) {
+		return lo + (hi - lo) * Uniform();
+	}
+
+	/** \brief 64λϺsplitmix64 */
+	static inline uint64 Mix(uint64 z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+private:
+	/** \brief Կ */
+	uint64 key_;
+	/** \brief  */
+	uint64 counter_;
+};
+
+#endif
@@ -0,0 +1,866 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_simd
+*/
+
+#include "stdafx.h"
+#include "pms_simd.h"
+#include "cost_computor.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PMS_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/ClangʹָչĺָĿ꣬MSVCָ
+// FMA˼ӺϲӲֵʵֲһ£ӲΧжϽͬ
+#if defined(__GNUC__) || defined(__clang__)
+#define PMS_TARGET_AVX2 __attribute__((target("avx2")))
+#define PMS_TARGET_AVX512 __attribute__((target("avx512f,avx2")))
+#else
+#define PMS_TARGET_AVX2
+#define PMS_TARGET_AVX512
+#endif
+
+/** \brief ÿۼӵѡƽ */
+constexpr sint32 Kernel_Batch = 32;
+
+namespace {
+	/**
+	 * \brief ƳֺѲСڴ޵ĺѡƽ棬䲿ֺ
+	 * ۾Ǹֺֻ˱Ƴĺѡƽմ۱ȻС
+	 * \param acc		ѡƽۼֵ
+	 * \param live		ۼӵĺѡƽ
+	 * \param num_live	ۼӵĺѡƽ
+	 * \param bound		
+	 * \param costs		ƳѡƽĲֺ
+	 * \param sum		ۼֵͺ
+	 * \return Ƴۼӵĺѡƽ
+	 */
+	template <class Acc, class Sum>
+	inline sint32 RemoveExceeded(const Acc* acc, sint32* live, const sint32& num_live, const float32& bound, float32* costs, Sum sum)
+	{
+		sint32 n = 0;
+		for (sint32 i = 0; i < num_live; i++) {
+			const sint32 k = live[i];
+			const float32 partial = sum(acc[k]);
+			if (partial >= bound) {
+				costs[k] = partial;
+			}
+			else {
+				live[n++] = k;
+			}
+		}
+		return n;
+	}
+}
+
+#ifdef PMS_SIMD_X86
+namespace {
+	/** \brief ִCPUIDָ */
+	void Cpuid(uint32 info[4], const uint32& leaf, const uint32& sub)
+	{
+#ifdef _MSC_VER
+		int regs[4];
+		__cpuidex(regs, static_cast<int>(leaf), static_cast<int>(sub));
+		for (sint32 i = 0; i < 4; i++) {
+			info[i] = static_cast<uint32>(regs[i]);
+		}
+#else
+		__cpuid_count(leaf, sub, info[0], info[1], info[2], info[3]);
+#endif
+	}
+
+	/** \brief ȡXCR0ĴжϲϵͳǷ񱣴YMM/ZMM״̬ */
+	uint64 Xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32 lo, hi;
+		__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (static_cast<uint64>(hi) << 32) | lo;
+#endif
+	}
+
+	sint32 DetectSimdLevel()
+	{
+		uint32 info[4];
+		Cpuid(info, 0, 0);
+		if (info[0] < 7) {
+			return PMS_SIMD_SCALAR;
+		}
+		Cpuid(info, 1, 0);
+		const bool has_osxsave = (info[2] & (1u << 27)) != 0;
+		const bool has_avx = (info[2] & (1u << 28)) != 0;
+		if (!has_osxsave || !has_avx) {
+			return PMS_SIMD_SCALAR;
+		}
+		const uint64 xcr0 = Xgetbv();
+		if ((xcr0 & 0x6) != 0x6) {
+			return PMS_SIMD_SCALAR;
+		}
+		Cpuid(info, 7, 0);
+		const bool has_avx2 = (info[1] & (1u << 5)) != 0;
+		const bool has_avx512f = (info[1] & (1u << 16)) != 0;
+		if (!has_avx2) {
+			return PMS_SIMD_SCALAR;
+		}
+		if (has_avx512f && (xcr0 & 0xE6) == 0xE6) {
+			return PMS_SIMD_AVX512;
+		}
+		return PMS_SIMD_AVX2;
+	}
+
+	////
+	// AVX2
+
+	/** \brief 8ͨͣӷ˳̶ǰֹжսһ */
+	PMS_TARGET_AVX2 inline float32 HorizontalSum8(const __m256& v)
+	{
+		alignas(32) float32 sum[8];
+		_mm256_store_ps(sum, v);
+		return ((sum[0] + sum[1]) + (sum[2] + sum[3])) + ((sum[4] + sum[5]) + (sum[6] + sum[7]));
+	}
+
+	/** \brief ۺϴۣÿδһе8УSUBΪӰǷΪƽ */
+	template <sint32 PATCH, bool SUB>
+	PMS_TARGET_AVX2 sint64 ComputeA_AVX2(const PMSCostKernelArgs& args, const sint32& x, const sint32& y,
+		const DisparityPlane* planes, const sint32& num, const float32* weights, const float32& bound, float32* costs)
+	{
+		const sint32 width = args.width;
+		const sint32 height = args.height;
+		const sint32 stride = args.stride;
+		const sint32 patch_size = PATCH > 0 ? PATCH : args.patch_size;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width - 1 - x);
+		const sint32 step = args.sample_step;
+		// ÿеĲͳƲ
+		const sint64 row_samples = (c_max - pms_simd::FirstSample(c_min, step)) / step + 1;
+		sint64 samples = 0;
+
+		const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i lane_step = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step));
+		const __m256i v_one_i = _mm256_set1_epi32(1);
+		const __m256 v_zero = _mm256_setzero_ps();
+		const __m256 v_one = _mm256_set1_ps(1.0f);
+		const __m256 v_width = _mm256_set1_ps(static_cast<float32>(width));
+		const __m256 v_min_d = _mm256_set1_ps(args.min_disp);
+		const __m256 v_max_d = _mm256_set1_ps(args.max_disp);
+		const __m256 v_alpha = _mm256_set1_ps(args.alpha);
+		const __m256 v_alpha1 = _mm256_set1_ps(1 - args.alpha);
+		const __m256 v_tau_col = _mm256_set1_ps(args.tau_col);
+		const __m256 v_tau_grad = _mm256_set1_ps(args.tau_grad);
+		const __m256 v_out_cost = _mm256_set1_ps((1 - args.alpha) * args.tau_col + args.alpha * args.tau_grad);
+		const __m256 v_punish = _mm256_set1_ps(COST_PUNISH);
+		const __m256 v_abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		const __m256 v_sub = _mm256_set1_ps(static_cast<float32>(args.subpixel));
+		const __m256 v_half = _mm256_set1_ps(0.5f);
+
+		const bool is_bounded = bound < Unbounded_Cost;
+
+		for (sint32 k0 = 0; k0 < num; k0 += Kernel_Batch) {
+			const sint32 nk = std::min(Kernel_Batch, num - k0);
+			__m256 acc[Kernel_Batch];
+			// ۼӵĺѡƽ
+			sint32 live[Kernel_Batch];
+			sint32 num_live = nk;
+			for (sint32 k = 0; k < nk; k++) {
+				acc[k] = v_zero;
+				live[k] = k;
+			}
+			for (sint32 r = pms_simd::FirstSample(r_min, step); r <= r_max && num_live > 0; r += step) {
+				samples += row_samples * num_live;
+				const sint32 yr = y + r;
+				const sint32 row = yr * stride;
+				const float32* w_row = weights + (r + pat) * patch_size + pat;
+				const __m256 v_yr = _mm256_set1_ps(static_cast<float32>(yr));
+				const __m256i v_row_r = _mm256_set1_epi32(yr * args.right_stride);
+				for (sint32 c = pms_simd::FirstSample(c_min, step); c <= c_max; c += 8 * step) {
+					// Чͨĩβ8ʱζͨͨȡչ򣬲Խ磩
+					const __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32((c_max - c) / step + 1), lane);
+					const __m256 xc = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x + c), lane_step));
+
+					// Ӱ񴰿صɫݶȣкѡƽ湲
+					// ܴʱȡϡʱȡ
+					const sint32 ofs_l = row + x + c;
+					__m256 w, lb, lg, lr, lgx, lgy;
+					if (step == 1) {
+						w = _mm256_maskload_ps(w_row + c, valid);
+						lb = _mm256_loadu_ps(args.left[0] + ofs_l);
+						lg = _mm256_loadu_ps(args.left[1] + ofs_l);
+						lr = _mm256_loadu_ps(args.left[2] + ofs_l);
+						lgx = _mm256_loadu_ps(args.left[3] + ofs_l);
+						lgy = _mm256_loadu_ps(args.left[4] + ofs_l);
+					}
+					else {
+						const __m256 valid_ps = _mm256_castsi256_ps(valid);
+						w = _mm256_mask_i32gather_ps(v_zero, w_row + c, lane_step, valid_ps, 4);
+						lb = _mm256_mask_i32gather_ps(v_zero, args.left[0] + ofs_l, lane_step, valid_ps, 4);
+						lg = _mm256_mask_i32gather_ps(v_zero, args.left[1] + ofs_l, lane_step, valid_ps, 4);
+						lr = _mm256_mask_i32gather_ps(v_zero, args.left[2] + ofs_l, lane_step, valid_ps, 4);
+						lgx = _mm256_mask_i32gather_ps(v_zero, args.left[3] + ofs_l, lane_step, valid_ps, 4);
+						lgy = _mm256_mask_i32gather_ps(v_zero, args.left[4] + ofs_l, lane_step, valid_ps, 4);
+					}
+
+					for (sint32 i = 0; i < num_live; i++) {
+						const sint32 k = live[i];
+						const auto& pl = planes[k0 + k].p;
+						// Ӳֵ
+						const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xc, _mm256_set1_ps(pl.x)),
+							_mm256_mul_ps(v_yr, _mm256_set1_ps(pl.y))), _mm256_set1_ps(pl.z));
+						const __m256 in_range = _mm256_and_ps(_mm256_cmp_ps(d, v_min_d, _CMP_GE_OQ), _mm256_cmp_ps(d, v_max_d, _CMP_LE_OQ));
+
+						// Ӱͬ㣬Ӱͨȡ0Ա֤ȡȫx1+1Ϊwidthչ
+						const __m256 xr = _mm256_sub_ps(xc, d);
+						const __m256 in_img = _mm256_and_ps(_mm256_cmp_ps(xr, v_zero, _CMP_GE_OQ), _mm256_cmp_ps(xr, v_width, _CMP_LT_OQ));
+						const __m256 xr_safe = _mm256_and_ps(xr, in_img);
+						__m256 rv[5];
+						if (SUB) {
+							// ƽȡΪwidth*subpixelչ
+							const __m256i pix = _mm256_add_epi32(v_row_r, _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(xr_safe, v_sub), v_half)));
+							for (sint32 n = 0; n < 5; n++) {
+								rv[n] = _mm256_i32gather_ps(args.right[n], pix, 4);
+							}
+						}
+						else {
+							const __m256i x1 = _mm256_cvttps_epi32(xr_safe);
+							const __m256 ofs = _mm256_sub_ps(xr_safe, _mm256_cvtepi32_ps(x1));
+							const __m256 ofs1 = _mm256_sub_ps(v_one, ofs);
+							const __m256i pix1 = _mm256_add_epi32(v_row_r, x1);
+							const __m256i pix2 = _mm256_add_epi32(pix1, v_one_i);
+
+							// ӰɫݶԲֵ
+							for (sint32 n = 0; n < 5; n++) {
+								const __m256 v1 = _mm256_i32gather_ps(args.right[n], pix1, 4);
+								const __m256 v2 = _mm256_i32gather_ps(args.right[n], pix2, 4);
+								rv[n] = _mm256_add_ps(_mm256_mul_ps(ofs1, v1), _mm256_mul_ps(ofs, v2));
+							}
+						}
+
+						// ɫռݶȿռĽضϾԲ
+						__m256 dc = _mm256_add_ps(_mm256_and_ps(_mm256_sub_ps(lb, rv[0]), v_abs), _mm256_and_ps(_mm256_sub_ps(lg, rv[1]), v_abs));
+						dc = _mm256_min_ps(_mm256_add_ps(dc, _mm256_and_ps(_mm256_sub_ps(lr, rv[2]), v_abs)), v_tau_col);
+						__m256 dg = _mm256_add_ps(_mm256_and_ps(_mm256_sub_ps(lgx, rv[3]), v_abs), _mm256_and_ps(_mm256_sub_ps(lgy, rv[4]), v_abs));
+						dg = _mm256_min_ps(dg, v_tau_grad);
+
+						// ֵ
+						__m256 cost = _mm256_add_ps(_mm256_mul_ps(v_alpha1, dc), _mm256_mul_ps(v_alpha, dg));
+						cost = _mm256_blendv_ps(v_out_cost, cost, in_img);
+						__m256 contrib = _mm256_blendv_ps(v_punish, _mm256_mul_ps(w, cost), in_range);
+						contrib = _mm256_and_ps(contrib, _mm256_castsi256_ps(valid));
+						acc[k] = _mm256_add_ps(acc[k], contrib);
+					}
+				}
+				if (is_bounded) {
+					num_live = RemoveExceeded(acc, live, num_live, bound, costs + k0, HorizontalSum8);
+				}
+			}
+			for (sint32 i = 0; i < num_live; i++) {
+				costs[k0 + live[i]] = HorizontalSum8(acc[live[i]]);
+			}
+		}
+		return samples;
+	}
+
+	/** \brief 8ͨint32ͲΪ */
+	PMS_TARGET_AVX2 inline float32 HorizontalSumFixed8(const __m256i& v)
+	{
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		return static_cast<float32>(_mm_cvtsi128_si32(sum)) * (1.0f / (1 << (Fixed_Frac_Bits + Fixed_Weight_Bits)));
+	}
+
+	/** \brief 8ͨint32ѹΪ16ͨint16ͨ˳ */
+	PMS_TARGET_AVX2 inline __m256i Pack16(const __m256i& lo, const __m256i& hi)
+	{
+		return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	/** \brief ȡ16int16ofs_lo/ofs_hiΪǰ8Ԫصƫƣmask_lo/mask_hiΪЧͨ */
+	PMS_TARGET_AVX2 inline __m256i Gather16(const sint16* ptr, const __m256i& ofs_lo, const __m256i& ofs_hi,
+		const __m256i& mask_lo, const __m256i& mask_hi)
+	{
+		const auto* base = reinterpret_cast<const int*>(ptr);
+		const __m256i zero = _mm256_setzero_si256();
+		// ÿζȡ4ֽڣ16λΪԪأչѹ
+		const __m256i lo = _mm256_mask_i32gather_epi32(zero, base, ofs_lo, mask_lo, 2);
+		const __m256i hi = _mm256_mask_i32gather_epi32(zero, base, ofs_hi, mask_hi, 2);
+		return Pack16(_mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16), _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16));
+	}
+
+	/** \brief ۺϴۣÿδһе16УɫݶȰ16λͨ */
+	template <sint32 PATCH>
+	PMS_TARGET_AVX2 sint64 ComputeAFixed_AVX2(const PMSCostKernelArgsFixed& args, const sint32& x, const sint32& y,
+		const DisparityPlane* planes, const sint32& num, const sint16* weights, const float32& bound, float32* costs)
+	{
+		const sint32 width = args.width;
+		const sint32 height = args.height;
+		const sint32 stride = args.stride;
+		const sint32 patch_size = PATCH > 0 ? PATCH : args.patch_size;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width - 1 - x);
+		const sint32 step = args.sample_step;
+		// ÿеĲͳƲ
+		const sint64 row_samples = (c_max - pms_simd::FirstSample(c_min, step)) / step + 1;
+		sint64 samples = 0;
+
+		const __m256i lane16 = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i lane_lo = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step));
+		const __m256i lane_hi = _mm256_mullo_epi32(_mm256_add_epi32(lane, _mm256_set1_epi32(8)), _mm256_set1_epi32(step));
+		const __m256 v_zero = _mm256_setzero_ps();
+		const __m256 v_width = _mm256_set1_ps(static_cast<float32>(width));
+		const __m256 v_frac = _mm256_set1_ps(static_cast<float32>(1 << Fixed_Frac_Bits));
+		const __m256 v_min_d = _mm256_set1_ps(args.min_disp);
+		const __m256 v_max_d = _mm256_set1_ps(args.max_disp);
+		const __m256i v_frac_one = _mm256_set1_epi32(1 << Fixed_Frac_Bits);
+		const __m256i v_frac_mask = _mm256_set1_epi32((1 << Fixed_Frac_Bits) - 1);
+		const __m256i v_alpha_col = _mm256_set1_epi16(static_cast<sint16>(args.alpha_col));
+		const __m256i v_alpha_grad = _mm256_set1_epi16(static_cast<sint16>(args.alpha_grad));
+		const __m256i v_tau_col = _mm256_set1_epi16(args.tau_col);
+		const __m256i v_tau_grad = _mm256_set1_epi16(args.tau_grad);
+		const __m256i v_out_cost = _mm256_set1_epi16(args.out_cost);
+		const __m256i v_punish = _mm256_set1_epi16(args.punish);
+		const __m256i v_weight_one = _mm256_set1_epi16(1 << Fixed_Weight_Bits);
+
+		const bool is_bounded = bound < Unbounded_Cost;
+
+		for (sint32 k0 = 0; k0 < num; k0 += Kernel_Batch) {
+			const sint32 nk = std::min(Kernel_Batch, num - k0);
+			__m256i acc[Kernel_Batch];
+			// ۼӵĺѡƽ
+			sint32 live[Kernel_Batch];
+			sint32 num_live = nk;
+			for (sint32 k = 0; k < nk; k++) {
+				acc[k] = _mm256_setzero_si256();
+				live[k] = k;
+			}
+			for (sint32 r = pms_simd::FirstSample(r_min, step); r <= r_max && num_live > 0; r += step) {
+				samples += row_samples * num_live;
+				const sint32 yr = y + r;
+				const sint32 row = yr * stride;
+				const sint16* w_row = weights + (r + pat) * patch_size + pat;
+				const __m256 v_yr = _mm256_set1_ps(static_cast<float32>(yr));
+				const __m256i v_row = _mm256_set1_epi32(row);
+				for (sint32 c = pms_simd::FirstSample(c_min, step); c <= c_max; c += 16 * step) {
+					// Чͨĩβ16ʱζͨͨȡչȨֵԤ򣬲Խ磩
+					const sint32 count = (c_max - c) / step + 1;
+					const __m256i valid = _mm256_cmpgt_epi16(_mm256_set1_epi16(static_cast<sint16>(std::min(count, 16))), lane16);
+					const __m256 xc_lo = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x + c), lane_lo));
+					const __m256 xc_hi = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x + c), lane_hi));
+
+					// Ӱ񴰿صɫݶȣŴΪ1/32λȨֵкѡƽ湲
+					const sint32 ofs_l = row + x + c;
+					__m256i w, lv[5];
+					if (step == 1) {
+						w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w_row + c));
+						for (sint32 n = 0; n < 5; n++) {
+							lv[n] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.left[n] + ofs_l));
+						}
+					}
+					else {
+						const __m256i mask_lo = _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lane);
+						const __m256i mask_hi = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - 8), lane);
+						w = Gather16(w_row + c, lane_lo, lane_hi, mask_lo, mask_hi);
+						for (sint32 n = 0; n < 5; n++) {
+							lv[n] = Gather16(args.left[n] + ofs_l, lane_lo, lane_hi, mask_lo, mask_hi);
+						}
+					}
+					w = _mm256_and_si256(w, valid);
+					for (sint32 n = 0; n < 5; n++) {
+						lv[n] = _mm256_slli_epi16(lv[n], Fixed_Frac_Bits);
+					}
+
+					for (sint32 i = 0; i < num_live; i++) {
+						const sint32 k = live[i];
+						const auto& pl = planes[k0 + k].p;
+						const __m256 v_a = _mm256_set1_ps(pl.x);
+						const __m256 v_b = _mm256_mul_ps(v_yr, _mm256_set1_ps(pl.y));
+						const __m256 v_c = _mm256_set1_ps(pl.z);
+						__m256i rv[5], in_range, in_img;
+						{
+							// ǰ8зֱӲͬ㣬ӲΧж븡ʵһ
+							__m256i rv_half[2][5], in_range_half[2], in_img_half[2];
+							for (sint32 h = 0; h < 2; h++) {
+								const __m256 xc = h == 0 ? xc_lo : xc_hi;
+								const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xc, v_a), v_b), v_c);
+								const __m256 range = _mm256_and_ps(_mm256_cmp_ps(d, v_min_d, _CMP_GE_OQ), _mm256_cmp_ps(d, v_max_d, _CMP_LE_OQ));
+								const __m256 xr = _mm256_sub_ps(xc, d);
+								const __m256 img = _mm256_and_ps(_mm256_cmp_ps(xr, v_zero, _CMP_GE_OQ), _mm256_cmp_ps(xr, v_width, _CMP_LT_OQ));
+								in_range_half[h] = _mm256_castps_si256(range);
+								in_img_half[h] = _mm256_castps_si256(img);
+
+								// ͬΪ1/32أӰͨȡ0Ա֤ȡȫ
+								const __m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_and_ps(xr, img), v_frac));
+								const __m256i x1 = _mm256_srai_epi32(q, Fixed_Frac_Bits);
+								const __m256i f = _mm256_and_si256(q, v_frac_mask);
+								const __m256i pix = _mm256_add_epi32(v_row, x1);
+								// ֵϵԣ16λΪx1ϵ16λΪx1+1ϵ
+								const __m256i coef = _mm256_or_si256(_mm256_sub_epi32(v_frac_one, f), _mm256_slli_epi32(f, 16));
+								for (sint32 n = 0; n < 5; n++) {
+									// һζȡx1x1+1
+									const __m256i pair = _mm256_i32gather_epi32(reinterpret_cast<const int*>(args.right[n]), pix, 2);
+									rv_half[h][n] = _mm256_madd_epi16(pair, coef);
+								}
+							}
+							for (sint32 n = 0; n < 5; n++) {
+								rv[n] = Pack16(rv_half[0][n], rv_half[1][n]);
+							}
+							in_range = Pack16(in_range_half[0], in_range_half[1]);
+							in_img = Pack16(in_img_half[0], in_img_half[1]);
+						}
+
+						// ɫռݶȿռĽضϾԲ
+						__m256i dc = _mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(lv[0], rv[0])), _mm256_abs_epi16(_mm256_sub_epi16(lv[1], rv[1])));
+						dc = _mm256_min_epi16(_mm256_add_epi16(dc, _mm256_abs_epi16(_mm256_sub_epi16(lv[2], rv[2]))), v_tau_col);
+						__m256i dg = _mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(lv[3], rv[3])), _mm256_abs_epi16(_mm256_sub_epi16(lv[4], rv[4])));
+						dg = _mm256_min_epi16(dg, v_tau_grad);
+
+						// شۣӲΧʱΪͷֵҲȨ
+						__m256i cost = _mm256_add_epi16(_mm256_mulhi_epu16(dc, v_alpha_col), _mm256_mulhi_epu16(dg, v_alpha_grad));
+						cost = _mm256_blendv_epi8(v_out_cost, cost, in_img);
+						cost = _mm256_blendv_epi8(v_punish, cost, in_range);
+						__m256i w_eff = _mm256_blendv_epi8(v_weight_one, w, in_range);
+						w_eff = _mm256_and_si256(w_eff, valid);
+						acc[k] = _mm256_add_epi32(acc[k], _mm256_madd_epi16(cost, w_eff));
+					}
+				}
+				if (is_bounded) {
+					num_live = RemoveExceeded(acc, live, num_live, bound, costs + k0, HorizontalSumFixed8);
+				}
+			}
+			for (sint32 i = 0; i < num_live; i++) {
+				costs[k0 + live[i]] = HorizontalSumFixed8(acc[live[i]]);
+			}
+		}
+		return samples;
+	}
+
+	////
+	// AVX-512
+
+	// GCCavx512fintrin.hδʼΪ_mm512_undefined_*ķֵδʼ棨GCC Bug 105593
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+	/** \brief 16ֵͨ */
+	PMS_TARGET_AVX512 inline __m512 Abs16(const __m512& v)
+	{
+		return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(v), _mm512_set1_epi32(0x7FFFFFFF)));
+	}
+
+	/** \brief 16ͨ */
+	PMS_TARGET_AVX512 inline float32 HorizontalSum16(const __m512& v)
+	{
+		return _mm512_reduce_add_ps(v);
+	}
+
+	/** \brief ۺϴۣÿδһе16УSUBΪӰǷΪƽ */
+	template <sint32 PATCH, bool SUB>
+	PMS_TARGET_AVX512 sint64 ComputeA_AVX512(const PMSCostKernelArgs& args, const sint32& x, const sint32& y,
+		const DisparityPlane* planes, const sint32& num, const float32* weights, const float32& bound, float32* costs)
+	{
+		const sint32 width = args.width;
+		const sint32 height = args.height;
+		const sint32 stride = args.stride;
+		const sint32 patch_size = PATCH > 0 ? PATCH : args.patch_size;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width - 1 - x);
+		const sint32 step = args.sample_step;
+		// ÿеĲͳƲ
+		const sint64 row_samples = (c_max - pms_simd::FirstSample(c_min, step)) / step + 1;
+		sint64 samples = 0;
+
+		const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		const __m512i lane_step = _mm512_mullo_epi32(lane, _mm512_set1_epi32(step));
+		const __m512i v_one_i = _mm512_set1_epi32(1);
+		const __m512 v_zero = _mm512_setzero_ps();
+		const __m512 v_one = _mm512_set1_ps(1.0f);
+		const __m512 v_width = _mm512_set1_ps(static_cast<float32>(width));
+		const __m512 v_min_d = _mm512_set1_ps(args.min_disp);
+		const __m512 v_max_d = _mm512_set1_ps(args.max_disp);
+		const __m512 v_alpha = _mm512_set1_ps(args.alpha);
+		const __m512 v_alpha1 = _mm512_set1_ps(1 - args.alpha);
+		const __m512 v_tau_col = _mm512_set1_ps(args.tau_col);
+		const __m512 v_tau_grad = _mm512_set1_ps(args.tau_grad);
+		const __m512 v_out_cost = _mm512_set1_ps((1 - args.alpha) * args.tau_col + args.alpha * args.tau_grad);
+		const __m512 v_punish = _mm512_set1_ps(COST_PUNISH);
+		const __m512 v_sub = _mm512_set1_ps(static_cast<float32>(args.subpixel));
+		const __m512 v_half = _mm512_set1_ps(0.5f);
+
+		const bool is_bounded = bound < Unbounded_Cost;
+
+		for (sint32 k0 = 0; k0 < num; k0 += Kernel_Batch) {
+			const sint32 nk = std::min(Kernel_Batch, num - k0);
+			__m512 acc[Kernel_Batch];
+			// ۼӵĺѡƽ
+			sint32 live[Kernel_Batch];
+			sint32 num_live = nk;
+			for (sint32 k = 0; k < nk; k++) {
+				acc[k] = v_zero;
+				live[k] = k;
+			}
+			for (sint32 r = pms_simd::FirstSample(r_min, step); r <= r_max && num_live > 0; r += step) {
+				samples += row_samples * num_live;
+				const sint32 yr = y + r;
+				const sint32 row = yr * stride;
+				const float32* w_row = weights + (r + pat) * patch_size + pat;
+				const __m512 v_yr = _mm512_set1_ps(static_cast<float32>(yr));
+				const __m512i v_row_r = _mm512_set1_epi32(yr * args.right_stride);
+				for (sint32 c = pms_simd::FirstSample(c_min, step); c <= c_max; c += 16 * step) {
+					// Чͨĩβ16ʱζͨͨȡչ򣬲Խ磩
+					const __mmask16 valid = _mm512_cmpgt_epi32_mask(_mm512_set1_epi32((c_max - c) / step + 1), lane);
+					const __m512 xc = _mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_set1_epi32(x + c), lane_step));
+
+					// Ӱ񴰿صɫݶȣкѡƽ湲
+					// ܴʱȡϡʱȡ
+					const sint32 ofs_l = row + x + c;
+					__m512 w, lb, lg, lr, lgx, lgy;
+					if (step == 1) {
+						w = _mm512_maskz_loadu_ps(valid, w_row + c);
+						lb = _mm512_loadu_ps(args.left[0] + ofs_l);
+						lg = _mm512_loadu_ps(args.left[1] + ofs_l);
+						lr = _mm512_loadu_ps(args.left[2] + ofs_l);
+						lgx = _mm512_loadu_ps(args.left[3] + ofs_l);
+						lgy = _mm512_loadu_ps(args.left[4] + ofs_l);
+					}
+					else {
+						w = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, w_row + c, 4);
+						lb = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, args.left[0] + ofs_l, 4);
+						lg = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, args.left[1] + ofs_l, 4);
+						lr = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, args.left[2] + ofs_l, 4);
+						lgx = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, args.left[3] + ofs_l, 4);
+						lgy = _mm512_mask_i32gather_ps(v_zero, valid, lane_step, args.left[4] + ofs_l, 4);
+					}
+
+					for (sint32 i = 0; i < num_live; i++) {
+						const sint32 k = live[i];
+						const auto& pl = planes[k0 + k].p;
+						// Ӳֵ
+						const __m512 d = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(xc, _mm512_set1_ps(pl.x)),
+							_mm512_mul_ps(v_yr, _mm512_set1_ps(pl.y))), _mm512_set1_ps(pl.z));
+						const __mmask16 in_range = _mm512_cmp_ps_mask(d, v_min_d, _CMP_GE_OQ) & _mm512_cmp_ps_mask(d, v_max_d, _CMP_LE_OQ);
+
+						// Ӱͬ㣬Ӱͨȡ0Ա֤ȡȫx1+1Ϊwidthչ
+						const __m512 xr = _mm512_sub_ps(xc, d);
+						const __mmask16 in_img = _mm512_cmp_ps_mask(xr, v_zero, _CMP_GE_OQ) & _mm512_cmp_ps_mask(xr, v_width, _CMP_LT_OQ);
+						const __m512 xr_safe = _mm512_maskz_mov_ps(in_img, xr);
+						__m512 rv[5];
+						if (SUB) {
+							// ƽȡΪwidth*subpixelչ
+							const __m512i pix = _mm512_add_epi32(v_row_r, _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(xr_safe, v_sub), v_half)));
+							for (sint32 n = 0; n < 5; n++) {
+								rv[n] = _mm512_i32gather_ps(pix, args.right[n], 4);
+							}
+						}
+						else {
+							const __m512i x1 = _mm512_cvttps_epi32(xr_safe);
+							const __m512 ofs = _mm512_sub_ps(xr_safe, _mm512_cvtepi32_ps(x1));
+							const __m512 ofs1 = _mm512_sub_ps(v_one, ofs);
+							const __m512i pix1 = _mm512_add_epi32(v_row_r, x1);
+							const __m512i pix2 = _mm512_add_epi32(pix1, v_one_i);
+
+							// ӰɫݶԲֵ
+							for (sint32 n = 0; n < 5; n++) {
+								const __m512 v1 = _mm512_i32gather_ps(pix1, args.right[n], 4);
+								const __m512 v2 = _mm512_i32gather_ps(pix2, args.right[n], 4);
+								rv[n] = _mm512_add_ps(_mm512_mul_ps(ofs1, v1), _mm512_mul_ps(ofs, v2));
+							}
+						}
+
+						// ɫռݶȿռĽضϾԲ
+						__m512 dc = _mm512_add_ps(Abs16(_mm512_sub_ps(lb, rv[0])), Abs16(_mm512_sub_ps(lg, rv[1])));
+						dc = _mm512_min_ps(_mm512_add_ps(dc, Abs16(_mm512_sub_ps(lr, rv[2]))), v_tau_col);
+						__m512 dg = _mm512_add_ps(Abs16(_mm512_sub_ps(lgx, rv[3])), Abs16(_mm512_sub_ps(lgy, rv[4])));
+						dg = _mm512_min_ps(dg, v_tau_grad);
+
+						// ֵ
+						__m512 cost = _mm512_add_ps(_mm512_mul_ps(v_alpha1, dc), _mm512_mul_ps(v_alpha, dg));
+						cost = _mm512_mask_blend_ps(in_img, v_out_cost, cost);
+						__m512 contrib = _mm512_mask_blend_ps(in_range, v_punish, _mm512_mul_ps(w, cost));
+						acc[k] = _mm512_mask_add_ps(acc[k], valid, acc[k], contrib);
+					}
+				}
+				if (is_bounded) {
+					num_live = RemoveExceeded(acc, live, num_live, bound, costs + k0, HorizontalSum16);
+				}
+			}
+			for (sint32 i = 0; i < num_live; i++) {
+				costs[k0 + live[i]] = HorizontalSum16(acc[live[i]]);
+			}
+		}
+		return samples;
+	}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+}
+#endif
+
+namespace {
+	/** \brief ۺϴۣʵ֣ͨݶȡSUBΪӰǷΪƽ */
+	template <sint32 PATCH, bool SUB>
+	sint64 ComputeA_Scalar(const PMSCostKernelArgs& args, const sint32& x, const sint32& y,
+		const DisparityPlane* planes, const sint32& num, const float32* weights, const float32& bound, float32* costs)
+	{
+		const sint32 width = args.width;
+		const sint32 height = args.height;
+		const sint32 stride = args.stride;
+		const sint32 patch_size = PATCH > 0 ? PATCH : args.patch_size;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width - 1 - x);
+		const sint32 step = args.sample_step;
+		// ÿеĲͳƲ
+		const sint64 row_samples = (c_max - pms_simd::FirstSample(c_min, step)) / step + 1;
+		sint64 samples = 0;
+		const float32 out_cost = (1 - args.alpha) * args.tau_col + args.alpha * args.tau_grad;
+		const float32 sub = static_cast<float32>(args.subpixel);
+		const bool is_bounded = bound < Unbounded_Cost;
+
+		for (sint32 k0 = 0; k0 < num; k0 += Kernel_Batch) {
+			const sint32 nk = std::min(Kernel_Batch, num - k0);
+			float32* cost = costs + k0;
+			const DisparityPlane* plane = planes + k0;
+			// ۼӵĺѡƽ
+			sint32 live[Kernel_Batch];
+			sint32 num_live = nk;
+			for (sint32 k = 0; k < nk; k++) {
+				cost[k] = 0.0f;
+				live[k] = k;
+			}
+			for (sint32 r = pms_simd::FirstSample(r_min, step); r <= r_max && num_live > 0; r += step) {
+				samples += row_samples * num_live;
+				const sint32 yr = y + r;
+				const sint32 row = yr * stride;
+				const sint32 row_r = yr * args.right_stride;
+				const float32* w_row = weights + (r + pat) * patch_size + pat;
+				for (sint32 c = pms_simd::FirstSample(c_min, step); c <= c_max; c += step) {
+					const sint32 xc = x + c;
+					float32 lv[5];
+					for (sint32 n = 0; n < 5; n++) {
+						lv[n] = args.left[n][row + xc];
+					}
+					const float32 w = w_row[c];
+					for (sint32 i = 0; i < num_live; i++) {
+						const sint32 k = live[i];
+						// Ӳֵ
+						const float32 d = plane[k].to_disparity(xc, yr);
+						if (d < args.min_disp || d > args.max_disp) {
+							cost[k] += COST_PUNISH;
+							continue;
+						}
+						const float32 xr = xc - d;
+						if (xr < 0.0f || xr >= static_cast<float32>(width)) {
+							cost[k] += w * out_cost;
+							continue;
+						}
+						float32 rv[5];
+						if (SUB) {
+							// ƽȡ
+							const sint32 pix = row_r + static_cast<sint32>(xr * sub + 0.5f);
+							for (sint32 n = 0; n < 5; n++) {
+								rv[n] = args.right[n][pix];
+							}
+						}
+						else {
+							// ӰɫݶԲֵx1+1Ϊwidthչ
+							const sint32 x1 = static_cast<sint32>(xr);
+							const float32 ofs = xr - x1;
+							for (sint32 n = 0; n < 5; n++) {
+								const float32* p = args.right[n] + row_r + x1;
+								rv[n] = (1 - ofs) * p[0] + ofs * p[1];
+							}
+						}
+						const float32 dc = std::min(std::fabs(lv[0] - rv[0]) + std::fabs(lv[1] - rv[1]) + std::fabs(lv[2] - rv[2]), args.tau_col);
+						const float32 dg = std::min(std::fabs(lv[3] - rv[3]) + std::fabs(lv[4] - rv[4]), args.tau_grad);
+						cost[k] += w * ((1 - args.alpha) * dc + args.alpha * dg);
+					}
+				}
+				if (is_bounded) {
+					num_live = RemoveExceeded(cost, live, num_live, bound, cost, [](const float32& v) { return v; });
+				}
+			}
+		}
+		return samples;
+	}
+}
+
+namespace {
+	/** \brief ۺϴۣʵ֣AVX2ʵλһ */
+	template <sint32 PATCH>
+	sint64 ComputeAFixed_Scalar(const PMSCostKernelArgsFixed& args, const sint32& x, const sint32& y,
+		const DisparityPlane* planes, const sint32& num, const sint16* weights, const float32& bound, float32* costs)
+	{
+		const sint32 width = args.width;
+		const sint32 height = args.height;
+		const sint32 stride = args.stride;
+		const sint32 patch_size = PATCH > 0 ? PATCH : args.patch_size;
+		const sint32 pat = patch_size / 2;
+		const sint32 r_min = std::max(-pat, -y), r_max = std::min(pat, height - 1 - y);
+		const sint32 c_min = std::max(-pat, -x), c_max = std::min(pat, width - 1 - x);
+		const sint32 step = args.sample_step;
+		// ÿеĲͳƲ
+		const sint64 row_samples = (c_max - pms_simd::FirstSample(c_min, step)) / step + 1;
+		sint64 samples = 0;
+		const sint32 frac_one = 1 << Fixed_Frac_Bits;
+		const float32 scale = 1.0f / (1 << (Fixed_Frac_Bits + Fixed_Weight_Bits));
+		const sint32 punish = args.punish << Fixed_Weight_Bits;
+		const bool is_bounded = bound < Unbounded_Cost;
+
+		for (sint32 k0 = 0; k0 < num; k0 += Kernel_Batch) {
+			const sint32 nk = std::min(Kernel_Batch, num - k0);
+			const DisparityPlane* plane = planes + k0;
+			sint32 acc[Kernel_Batch];
+			// ۼӵĺѡƽ
+			sint32 live[Kernel_Batch];
+			sint32 num_live = nk;
+			for (sint32 k = 0; k < nk; k++) {
+				acc[k] = 0;
+				live[k] = k;
+			}
+			for (sint32 r = pms_simd::FirstSample(r_min, step); r <= r_max && num_live > 0; r += step) {
+				samples += row_samples * num_live;
+				const sint32 yr = y + r;
+				const sint32 row = yr * stride;
+				const sint16* w_row = weights + (r + pat) * patch_size + pat;
+				for (sint32 c = pms_simd::FirstSample(c_min, step); c <= c_max; c += step) {
+					const sint32 xc = x + c;
+					sint32 lv[5];
+					for (sint32 n = 0; n < 5; n++) {
+						lv[n] = args.left[n][row + xc] * frac_one;
+					}
+					const sint32 w = w_row[c];
+					for (sint32 i = 0; i < num_live; i++) {
+						const sint32 k = live[i];
+						// Ӳֵ
+						const float32 d = plane[k].to_disparity(xc, yr);
+						if (d < args.min_disp || d > args.max_disp) {
+							acc[k] += punish;
+							continue;
+						}
+						const float32 xr = xc - d;
+						if (xr < 0.0f || xr >= static_cast<float32>(width)) {
+							acc[k] += w * args.out_cost;
+							continue;
+						}
+						// ͬΪ1/32أӰɫݶԲֵ
+						const sint32 q = static_cast<sint32>(xr * static_cast<float32>(frac_one));
+						const sint32 x1 = q >> Fixed_Frac_Bits;
+						const sint32 f = q & (frac_one - 1);
+						sint32 rv[5];
+						for (sint32 n = 0; n < 5; n++) {
+							const sint16* p = args.right[n] + row + x1;
+							rv[n] = p[0] * (frac_one - f) + p[1] * f;
+						}
+						const sint32 dc = std::min(abs(lv[0] - rv[0]) + abs(lv[1] - rv[1]) + abs(lv[2] - rv[2]), static_cast<sint32>(args.tau_col));
+						const sint32 dg = std::min(abs(lv[3] - rv[3]) + abs(lv[4] - rv[4]), static_cast<sint32>(args.tau_grad));
+						const sint32 cost = ((dc * args.alpha_col) >> 16) + ((dg * args.alpha_grad) >> 16);
+						acc[k] += w * cost;
+					}
+				}
+				if (is_bounded) {
+					num_live = RemoveExceeded(acc, live, num_live, bound, costs + k0, [scale](const sint32& v) { return v * scale; });
+				}
+			}
+			for (sint32 i = 0; i < num_live; i++) {
+				costs[k0 + live[i]] = acc[live[i]] * scale;
+			}
+		}
+		return samples;
+	}
+}
+
+sint32 pms_simd::GetCpuSimdLevel()
+{
+#ifdef PMS_SIMD_X86
+	static const sint32 level = DetectSimdLevel();
+	return level;
+#else
+	return PMS_SIMD_SCALAR;
+#endif
+}
+
+namespace {
+	/** \brief ڳߴѡػĺ˺ߴʹͨð汾 */
+	template <template <sint32> class Selector>
+	auto SelectPatch(const sint32& patch_size) -> decltype(Selector<0>::Get())
+	{
+		switch (patch_size) {
+		case 11:
+			return Selector<11>::Get();
+		case 21:
+			return Selector<21>::Get();
+		case 35:
+			return Selector<35>::Get();
+		default:
+			return Selector<0>::Get();
+		}
+	}
+
+	template <sint32 PATCH, bool SUB>
+	struct ScalarKernelT { static PMSCostKernel Get() { return ComputeA_Scalar<PATCH, SUB>; } };
+	template <sint32 PATCH>
+	using ScalarKernel = ScalarKernelT<PATCH, false>;
+	template <sint32 PATCH>
+	using ScalarKernelSub = ScalarKernelT<PATCH, true>;
+	template <sint32 PATCH>
+	struct ScalarKernelFixed { static PMSCostKernelFixed Get() { return ComputeAFixed_Scalar<PATCH>; } };
+#ifdef PMS_SIMD_X86
+	template <sint32 PATCH, bool SUB>
+	struct Avx2KernelT { static PMSCostKernel Get() { return ComputeA_AVX2<PATCH, SUB>; } };
+	template <sint32 PATCH>
+	using Avx2Kernel = Avx2KernelT<PATCH, false>;
+	template <sint32 PATCH>
+	using Avx2KernelSub = Avx2KernelT<PATCH, true>;
+	template <sint32 PATCH, bool SUB>
+	struct Avx512KernelT { static PMSCostKernel Get() { return ComputeA_AVX512<PATCH, SUB>; } };
+	template <sint32 PATCH>
+	using Avx512Kernel = Avx512KernelT<PATCH, false>;
+	template <sint32 PATCH>
+	using Avx512KernelSub = Avx512KernelT<PATCH, true>;
+	template <sint32 PATCH>
+	struct Avx2KernelFixed { static PMSCostKernelFixed Get() { return ComputeAFixed_AVX2<PATCH>; } };
+#endif
+}
+
+PMSCostKernel pms_simd::GetCostKernel(const sint32& max_level, const sint32& patch_size, const bool& is_subpixel)
+{
+	const sint32 level = std::min(max_level, GetCpuSimdLevel());
+#ifdef PMS_SIMD_X86
+	if (level >= PMS_SIMD_AVX512) {
+		return is_subpixel ? SelectPatch<Avx512KernelSub>(patch_size) : SelectPatch<Avx512Kernel>(patch_size);
+	}
+	if (level >= PMS_SIMD_AVX2) {
+		return is_subpixel ? SelectPatch<Avx2KernelSub>(patch_size) : SelectPatch<Avx2Kernel>(patch_size);
+	}
+#endif
+	return is_subpixel ? SelectPatch<ScalarKernelSub>(patch_size) : SelectPatch<ScalarKernel>(patch_size);
+}
+
+PMSCostKernelFixed pms_simd::GetCostKernelFixed(const sint32& max_level, const sint32& patch_size)
+{
+	const sint32 level = std::min(max_level, GetCpuSimdLevel());
+#ifdef PMS_SIMD_X86
+	if (level >= PMS_SIMD_AVX2) {
+		return SelectPatch<Avx2KernelFixed>(patch_size);
+	}
+#endif
+	return SelectPatch<ScalarKernelFixed>(patch_size);
+}
@@ -0,0 +1,133 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_simd
+*/
+
+#ifndef PATCH_MATCH_STEREO_SIMD_H_
+#define PATCH_MATCH_STEREO_SIMD_H_
+#include "pms_types.h"
+#include <limits>
+
+/** \brief SIMDָ */
+enum PMSSimdLevel {
+	PMS_SIMD_SCALAR = 0,	// 
+	PMS_SIMD_AVX2 = 1,		// AVX28ͨ
+	PMS_SIMD_AVX512 = 2		// AVX-512F16ͨ
+};
+
+/**
+ * \brief ۺϴۺ˺ɴۼд
+ * ӰΪͨ洢չأȡӰx+1ʱжԽ
+ */
+struct PMSCostKernelArgs {
+	const float32* left[5];			// Ӱͨƽ棨BGRGxGy(0,0)ָ룬PlanarImage
+	const float32* right[5];		// Ӱͨƽ(0,0)ָ룬ʱΪƽ
+	sint32 stride;					// ƽпȣ
+	sint32 right_stride;			// Ӱƽпȣʱstrideͬ
+	sint32 subpixel;				// Ӱˮƽ>1ʱͬȡֵ
+	sint32 width;					// Ӱ
+	sint32 height;					// Ӱ
+	sint32 patch_size;				// ֲڳߴ
+	sint32 sample_step;				// ڲ
+	float32 min_disp;				// СӲ
+	float32 max_disp;				// Ӳ
+	float32 alpha;					// alpha
+	float32 tau_col;				// tau_col
+	float32 tau_grad;				// tau_grad
+};
+
+/** \brief ޴ޣۺϴۼ */
+constexpr float32 Unbounded_Cost = std::numeric_limits<float32>::max();
+
+/**
+ * \brief ۺϴۺ˺CostComputerPMS::ComputeA汾һ
+ * ָʱмѡƽĲֺͣС޵ĺѡƽֹͣۼӣֵΪֺͣСޣ
+ * δǰֹͣĺѡƽֵʱȫһ
+ * \param args		˺
+ * \param x			px
+ * \param y			py
+ * \param planes	ѡƽ
+ * \param num		ѡƽ
+ * \param weights	pĴȨֵ
+ * \param bound		ޣΪUnbounded_Costʱǰֹͣ
+ * \param costs		ѡƽľۺϴֵ
+ * \return ۼӵĴڲѡƽ֮ͣǰֹͣвƣ
+ */
+typedef sint64 (*PMSCostKernel)(const PMSCostKernelArgs& args, const sint32& x, const sint32& y,
+	const DisparityPlane* planes, const sint32& num, const float32* weights, const float32& bound, float32* costs);
+
+/** \brief ۵Сλɫݶȵزֵϵش۾1/32Ϊλ */
+constexpr sint32 Fixed_Frac_Bits = 5;
+/** \brief ȨֵСλȨֵ1.0Ӧ256 */
+constexpr sint32 Fixed_Weight_Bits = 8;
+
+/**
+ * \brief ۺϴۺ˺ɶۼд
+ * شΪ ((dc*alpha_col)>>16) + ((dg*alpha_grad)>>16)dcdgΪ1/32ΪλĽضϾԲint16Χ
+ * ۺϴΪ Ȩֵ*ش int32ۼӣʱΪ
+ */
+struct PMSCostKernelArgsFixed {
+	const sint16* left[5];			// Ӱͨint16ƽ棨BGRGxGy(0,0)ָ룬PlanarImage
+	const sint16* right[5];			// Ӱͨint16ƽ(0,0)ָ
+	sint32 stride;					// ƽпȣ
+	sint32 width;					// Ӱ
+	sint32 height;					// Ӱ
+	sint32 patch_size;				// ֲڳߴ
+	sint32 sample_step;				// ڲ
+	float32 min_disp;				// СӲ
+	float32 max_disp;				// Ӳ
+	uint16 alpha_col;				// ɫϵ (1-alpha)*65536
+	uint16 alpha_grad;				// ݶȴϵ alpha*65536
+	sint16 tau_col;					// ɫضֵ1/32λ
+	sint16 tau_grad;				// ݶȽضֵ1/32λ
+	sint16 out_cost;				// ͬ㳬Ӱʱشۣ1/32λ
+	sint16 punish;					// ӲΧʱشۣȨ1/32λ
+};
+
+/**
+ * \brief ۺϴۺ˺PMSCostKernelһ£ȨֵΪʽ
+ * \param weights	pĴȨֵÿpatch_sizeĩβԤ16Ԫعȡ
+ */
+typedef sint64 (*PMSCostKernelFixed)(const PMSCostKernelArgsFixed& args, const sint32& x, const sint32& y,
+	const DisparityPlane* planes, const sint32& num, const sint16* weights, const float32& bound, float32* costs);
+
+namespace pms_simd
+{
+	/**
+	 * \brief ڲΪstepʱСloĵһƫƣƫΪstepıܱ
+	 * \param lo		ʼƫƣ0
+	 * \param step		
+	 */
+	inline sint32 FirstSample(const sint32& lo, const sint32& step)
+	{
+		return -((-lo) / step) * step;
+	}
+
+	/**
+	 * \brief ͨCPUID⵱ǰCPUϵͳֵ֧SIMD
+	 * \return PMSSimdLevel
+	 */
+	sint32 GetCpuSimdLevel();
+
+	/**
+	 * \brief ȡָCPUֵ֧߼ľۺϴۺ˺
+	 * ôڳߴ磨112135رػ汾ѭΪ
+	 * \param max_level	ʹõ߼
+	 * \param patch_size	ڳߴ
+	 * \param is_subpixel	ӰǷΪƽ
+	 * \return ˺ʱذͨݶȡıʵ
+	 */
+	PMSCostKernel GetCostKernel(const sint32& max_level, const sint32& patch_size, const bool& is_subpixel = false);
+
+	/**
+	 * \brief ȡۺϴۺ˺λһ
+	 * ˺16λͨ㣬AVX-512ʹAVX2ʵ
+	 * \param max_level	ʹõ߼
+	 * \param patch_size	ڳߴ
+	 * \return ˺
+	 */
+	PMSCostKernelFixed GetCostKernelFixed(const sint32& max_level, const sint32& patch_size);
+}
+
+#endif
@@ -0,0 +1,160 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_storage
+*/
+
+#include "stdafx.h"
+#include "pms_storage.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/** \brief ϵͳڴҳС */
+static size_t GetPageSize()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+PMSStorage::PMSStorage(): data_(nullptr), size_(0), is_mapped_(false), file_(nullptr), mapping_(nullptr)
+{
+}
+
+PMSStorage::~PMSStorage()
+{
+	Release();
+}
+
+bool PMSStorage::Allocate(const size_t& bytes, const bool& is_mapped, const char* dir)
+{
+	Release();
+	if (bytes == 0) {
+		return false;
+	}
+
+	if (!is_mapped) {
+		data_ = new uint8[bytes];
+		size_ = bytes;
+		return true;
+	}
+
+#ifdef _WIN32
+	// ʱļرվʱԶɾ
+	char temp_dir[MAX_PATH], path[MAX_PATH];
+	if (dir == nullptr) {
+		if (GetTempPathA(MAX_PATH, temp_dir) == 0) {
+			return false;
+		}
+		dir = temp_dir;
+	}
+	if (GetTempFileNameA(dir, "pms", 0, path) == 0) {
+		return false;
+	}
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		DeleteFileA(path);
+		return false;
+	}
+	const auto size = static_cast<uint64>(bytes);
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_ = file;
+	mapping_ = mapping;
+#else
+	// ʱļӳɾĿ¼ӳϵͳ
+	std::string path = dir ? dir : (getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+	path += "/pms_XXXXXX";
+	const sint32 fd = mkstemp(&path[0]);
+	if (fd < 0) {
+		return false;
+	}
+	unlink(path.c_str());
+	if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+#endif
+	data_ = data;
+	size_ = bytes;
+	is_mapped_ = true;
+	return true;
+}
+
+void PMSStorage::Release()
+{
+	if (data_ == nullptr) {
+		return;
+	}
+	if (!is_mapped_) {
+		auto* data = static_cast<uint8*>(data_);
+		SAFE_DELETE(data);
+	}
+	else {
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+		CloseHandle(static_cast<HANDLE>(mapping_));
+		CloseHandle(static_cast<HANDLE>(file_));
+#else
+		munmap(data_, size_);
+#endif
+	}
+	data_ = nullptr;
+	file_ = mapping_ = nullptr;
+	size_ = 0;
+	is_mapped_ = false;
+}
+
+void PMSStorage::Prefetch(size_t offset, size_t bytes) const
+{
+	if (!is_mapped_ || offset >= size_) {
+		return;
+	}
+	bytes = std::min(bytes, size_ - offset);
+
+	// ʼַҳ
+	static const size_t page = GetPageSize();
+	const size_t begin = offset / page * page;
+	bytes += offset - begin;
+	auto* addr = static_cast<uint8*>(data_) + begin;
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = addr;
+	range.NumberOfBytes = bytes;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(addr, bytes, MADV_WILLNEED);
+#endif
+}
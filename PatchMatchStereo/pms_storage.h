@@ -0,0 +1,66 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_storage
+*/
+
+#ifndef PATCH_MATCH_STEREO_STORAGE_H_
+#define PATCH_MATCH_STEREO_STORAGE_H_
+#include "pms_types.h"
+#include <cstddef>
+
+/**
+ * \brief ݴ洢
+ * ṩһڴ棬λڶڴ棬ҲλڴӳʱļУɲϵͳ軻뻻ڳӰ
+ * ʱļͷʱԶɾ
+ */
+class PMSStorage {
+public:
+	PMSStorage();
+	~PMSStorage();
+
+	PMSStorage(const PMSStorage&) = delete;
+	PMSStorage& operator=(const PMSStorage&) = delete;
+
+	/**
+	 * \brief 洢ռ
+	 * \param bytes		ֽ
+	 * \param is_mapped	Ƿʹڴӳʱļ
+	 * \param dir		ʱļĿ¼nullptrʱΪϵͳʱĿ¼
+	 * \return Ƿɹ
+	 */
+	bool Allocate(const size_t& bytes, const bool& is_mapped, const char* dir = nullptr);
+
+	/** \brief ͷŴ洢ռ */
+	void Release();
+
+	/**
+	 * \brief Ԥȡ[offset,offset+bytes)֪ͨϵͳǰ첽룬ڴӳʱЧ
+	 * \param offset		ʼֽƫ
+	 * \param bytes		ֽ
+	 */
+	void Prefetch(size_t offset, size_t bytes) const;
+
+	/** \brief ָ */
+	template<class T>
+	inline T* data() const { return static_cast<T*>(data_); }
+
+	/** \brief ֽ */
+	inline size_t size() const { return size_; }
+
+	/** \brief Ƿλڴӳļ */
+	inline bool is_mapped() const { return is_mapped_; }
+
+private:
+	/** \brief ָ */
+	void* data_;
+	/** \brief ֽ */
+	size_t size_;
+	/** \brief Ƿλڴӳļ */
+	bool is_mapped_;
+	/** \brief ļӳ */
+	void* file_;
+	void* mapping_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of plane locks and pixel stamps
+*/
+
+#ifndef PATCH_MATCH_STEREO_SYNC_HPP_
+#define PATCH_MATCH_STEREO_SYNC_HPP_
+#include "pms_types.h"
+#include <atomic>
+#include <thread>
+
+/**
+ * \brief Ӳƽ
+ * ͼʱͼдһͼƽ漰ۣһͼĴɾ
+ * Žӳ䵽̶ϣ֤(ƽ,)ԵĶдԭӵ
+ */
+class PlaneLocks {
+public:
+	/**
+	 * \brief 
+	 * \param num_locks	Ϊ2
+	 */
+	explicit PlaneLocks(const sint32& num_locks = 65536) : mask_(num_locks - 1) {
+		locks_ = new std::atomic_flag[num_locks];
+		for (sint32 i = 0; i < num_locks; i++) {
+			locks_[i].clear();
+		}
+	}
+
+	~PlaneLocks() {
+		SAFE_DELETE(locks_);
+	}
+
+	PlaneLocks(const PlaneLocks&) = delete;
+	PlaneLocks& operator=(const PlaneLocks&) = delete;
+
+	/** \brief p */
+	inline void lock(const sint32& p) const {
+		auto& flag = locks_[p & mask_];
+		sint32 spins = 0;
+		while (flag.test_and_set(std::memory_order_acquire)) {
+			if (++spins > 64) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/** \brief p */
+	inline void unlock(const sint32& p) const {
+		locks_[p & mask_].clear(std::memory_order_release);
+	}
+
+private:
+	/** \brief  */
+	std::atomic_flag* locks_;
+	/** \brief  */
+	sint32 mask_;
+};
+
+/**
+ * \brief ر仯
+ * ¼ÿصƽһαʱڵĵţ+10ʾδ£жǷҪ·
+ * ͼʱһ̻߳ͬʱдrelaxedԭӲʣľֵֻӰǷ񱻷ʣƻƽ
+ */
+class PixelStamps {
+public:
+	/**
+	 * \brief 죬رΪ0
+	 * \param num_pixels	
+	 */
+	explicit PixelStamps(const sint32& num_pixels) {
+		stamps_ = new std::atomic<sint32>[num_pixels];
+		for (sint32 i = 0; i < num_pixels; i++) {
+			stamps_[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	~PixelStamps() {
+		SAFE_DELETE(stamps_);
+	}
+
+	PixelStamps(const PixelStamps&) = delete;
+	PixelStamps& operator=(const PixelStamps&) = delete;
+
+	/** \brief ȡpı */
+	inline sint32 get(const sint32& p) const {
+		return stamps_[p].load(std::memory_order_relaxed);
+	}
+
+	/** \brief pı */
+	inline void set(const sint32& p, const sint32& stamp) const {
+		stamps_[p].store(stamp, std::memory_order_relaxed);
+	}
+
+private:
+	/** \brief  */
+	std::atomic<sint32>* stamps_;
+};
+
+#endif
@@ -0,0 +1,168 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: implement of pms_tiled
+*/
+
+#include "stdafx.h"
+#include "pms_tiled.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+/** \brief Сߴ */
+constexpr sint32 Min_Tile_Core = 16;
+
+PMSTiledMatcher::PMSTiledMatcher(): width_(0), height_(0), halo_x_(0), halo_y_(0),
+                                    core_width_(0), core_height_(0), num_tiles_x_(0), num_tiles_y_(0),
+                                    tile_width_(0), tile_height_(0),
+                                    tile_left_(nullptr), tile_right_(nullptr), tile_disp_(nullptr),
+                                    is_initialized_(false) { }
+
+PMSTiledMatcher::~PMSTiledMatcher()
+{
+	Release();
+}
+
+bool PMSTiledMatcher::Initialize(const sint32& width, const sint32& height, const PMSOption& option, const sint64& memory_budget)
+{
+	Release();
+	is_initialized_ = false;
+
+	width_ = width;
+	height_ = height;
+	option_ = option;
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+
+	// صصĴڼͬھڿ
+	halo_y_ = option.patch_size / 2;
+	halo_x_ = halo_y_ + std::max(abs(option.min_disparity), abs(option.max_disparity));
+
+	// ȷߴ磬Ԥ㹻ʱֿ
+	const auto fits = [&](const sint32& cw, const sint32& ch) {
+		return EstimateTileMemory(cw, ch) <= memory_budget;
+	};
+	// [lo,hi]жֲԤֵʱlo-1
+	const auto search = [](sint32 lo, sint32 hi, const std::function<bool(sint32)>& ok) {
+		sint32 best = lo - 1;
+		while (lo <= hi) {
+			const sint32 mid = lo + (hi - lo) / 2;
+			if (ok(mid)) {
+				best = mid;
+				lo = mid + 1;
+			}
+			else {
+				hi = mid - 1;
+			}
+		}
+		return best;
+	};
+	const sint32 min_core = std::max(Min_Tile_Core, option.patch_size);
+	if (memory_budget <= 0 || fits(width, height)) {
+		core_width_ = width;
+		core_height_ = height;
+	}
+	else {
+		// ѡ飬ȡصпС
+		const auto work = [&](const sint32& cw, const sint32& ch) {
+			const sint64 tw = cw < width ? std::min(cw + 2 * halo_x_, width) : width;
+			const sint64 th = ch < height ? std::min(ch + 2 * halo_y_, height) : height;
+			return ((width + cw - 1) / cw) * ((height + ch - 1) / ch) * tw * th;
+		};
+		const sint32 min_strip = std::min(min_core, height);
+		const sint32 strip_height = search(min_strip, height, [&](sint32 ch) { return fits(width, ch); });
+		const sint32 size = search(min_core, std::max(width, height), [&](sint32 s) {
+			return fits(std::min(s, width), std::min(s, height));
+		});
+		if (strip_height < min_strip && size < min_core) {
+			return false;
+		}
+		if (size < min_core || (strip_height >= min_strip &&
+			work(width, strip_height) <= work(std::min(size, width), std::min(size, height)))) {
+			core_width_ = width;
+			core_height_ = strip_height;
+		}
+		else {
+			core_width_ = std::min(size, width);
+			core_height_ = std::min(size, height);
+		}
+	}
+	num_tiles_x_ = (width + core_width_ - 1) / core_width_;
+	num_tiles_y_ = (height + core_height_ - 1) / core_height_;
+	tile_width_ = num_tiles_x_ > 1 ? std::min(core_width_ + 2 * halo_x_, width) : width;
+	tile_height_ = num_tiles_y_ > 1 ? std::min(core_height_ + 2 * halo_y_, height) : height;
+
+	// 黺漰ƥʵ
+	const sint64 tile_size = static_cast<sint64>(tile_width_) * tile_height_;
+	tile_left_ = new uint8[tile_size * 3];
+	tile_right_ = new uint8[tile_size * 3];
+	tile_disp_ = new float32[tile_size];
+	is_initialized_ = matcher_.Reset(tile_width_, tile_height_, option);
+
+	return is_initialized_;
+}
+
+sint64 PMSTiledMatcher::EstimateTileMemory(const sint32& core_width, const sint32& core_height) const
+{
+	const sint32 tw = core_width < width_ ? std::min(core_width + 2 * halo_x_, width_) : width_;
+	const sint32 th = core_height < height_ ? std::min(core_height + 2 * halo_y_, height_) : height_;
+	// ƥʵ + ӰӲ
+	return PatchMatchStereo::EstimateMemory(tw, th, option_) +
+		static_cast<sint64>(tw) * th * (2 * 3 * sizeof(uint8) + sizeof(float32));
+}
+
+void PMSTiledMatcher::Release()
+{
+	SAFE_DELETE(tile_left_);
+	SAFE_DELETE(tile_right_);
+	SAFE_DELETE(tile_disp_);
+}
+
+bool PMSTiledMatcher::Match(const uint8* img_left, const uint8* img_right, float32* disp_left)
+{
+	if (!is_initialized_) {
+		return false;
+	}
+	if (img_left == nullptr || img_right == nullptr || disp_left == nullptr) {
+		return false;
+	}
+
+	const sint64 width = width_;
+	const sint32 tw = tile_width_;
+	const sint32 th = tile_height_;
+	for (sint32 ty = 0; ty < num_tiles_y_; ty++) {
+		// [cy0,cy1)[wy0,wy0+th)߽紦Ŀƽ
+		const sint32 cy0 = ty * core_height_;
+		const sint32 cy1 = std::min(cy0 + core_height_, height_);
+		const sint32 wy0 = std::max(0, std::min(cy0 - halo_y_, height_ - th));
+		for (sint32 tx = 0; tx < num_tiles_x_; tx++) {
+			const sint32 cx0 = tx * core_width_;
+			const sint32 cx1 = std::min(cx0 + core_width_, width_);
+			const sint32 wx0 = std::max(0, std::min(cx0 - halo_x_, width_ - tw));
+
+			// ӰͼȡͬĿ򣬿ӲԭӰһ
+			for (sint32 y = 0; y < th; y++) {
+				const sint64 offset = ((wy0 + y) * width + wx0) * 3;
+				memcpy(tile_left_ + static_cast<sint64>(y) * tw * 3, img_left + offset, tw * 3);
+				memcpy(tile_right_ + static_cast<sint64>(y) * tw * 3, img_right + offset, tw * 3);
+			}
+
+			// 黥أһӲƽ棬Ƶģʽ±ǰһ֡
+			matcher_.ClearTemporalState();
+			if (!matcher_.Match(tile_left_, tile_right_, tile_disp_)) {
+				return false;
+			}
+
+			// ֻڿĺ򻥲صƴ޷
+			for (sint32 y = cy0; y < cy1; y++) {
+				memcpy(disp_left + y * width + cx0,
+					tile_disp_ + static_cast<sint64>(y - wy0) * tw + (cx0 - wx0),
+					(cx1 - cx0) * sizeof(float32));
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,98 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: header of pms_tiled
+*/
+
+#ifndef PATCH_MATCH_STEREO_TILED_H_
+#define PATCH_MATCH_STEREO_TILED_H_
+#include "pms_types.h"
+#include "PatchMatchStereo.h"
+
+/**
+ * \brief ֿƥ
+ * Ӱ񻮷Ϊɿ飬ÿչصhaloƥ䣬ֻӲ
+ * ˮƽصΪ봰ڼӲֵ֤صĴڼһͼͬڶڿڣֱصΪ봰
+ * ߴڴԤȷ߽紦ĿƽԱֳߴһ£鸴ͬһƥʵ黺棬ֵڴӰߴ޹
+ */
+class PMSTiledMatcher {
+public:
+	PMSTiledMatcher();
+	~PMSTiledMatcher();
+
+	PMSTiledMatcher(const PMSTiledMatcher&) = delete;
+	PMSTiledMatcher& operator=(const PMSTiledMatcher&) = delete;
+
+	/**
+	 * \brief ʼڴԤȷߴ
+	 * \param width			룬Ӱ
+	 * \param height			룬Ӱ
+	 * \param option			룬㷨
+	 * \param memory_budget	룬ƥ̿ڴ棨ֽڣӰӲͼ<=0ʱֿ
+	 * \return ǷɹԤ㲻Сʱfalse
+	 */
+	bool Initialize(const sint32& width, const sint32& height, const PMSOption& option, const sint64& memory_budget);
+
+	/**
+	 * \brief ִƥ
+	 * \param img_left	룬Ӱָ룬3ͨ
+	 * \param img_right	룬Ӱָ룬3ͨ
+	 * \param disp_left	ӰӲͼָ룬ԤȷӰȳߴڴռ
+	 */
+	bool Match(const uint8* img_left, const uint8* img_right, float32* disp_left);
+
+	/** \brief  */
+	inline sint32 core_width() const { return core_width_; }
+	/** \brief  */
+	inline sint32 core_height() const { return core_height_; }
+	/** \brief  */
+	inline sint32 num_tiles() const { return num_tiles_x_ * num_tiles_y_; }
+
+	/**
+	 * \brief ָĳߴĿƥڴ棨ֽڣƥʵPatchMatchStereo::EstimateMemoryӰ񡢿Ӳ
+	 * \param core_width		
+	 * \param core_height	
+	 */
+	sint64 EstimateTileMemory(const sint32& core_width, const sint32& core_height) const;
+
+private:
+	/** \brief ڴͷ */
+	void Release();
+
+private:
+	/** \brief PMS */
+	PMSOption option_;
+
+	/** \brief Ӱ */
+	sint32 width_;
+	sint32 height_;
+
+	/** \brief صȣˮƽֱ */
+	sint32 halo_x_;
+	sint32 halo_y_;
+
+	/** \brief ߴ */
+	sint32 core_width_;
+	sint32 core_height_;
+
+	/** \brief ˮƽֱ */
+	sint32 num_tiles_x_;
+	sint32 num_tiles_y_;
+
+	/** \brief ߴ磨صӰߴ磩 */
+	sint32 tile_width_;
+	sint32 tile_height_;
+
+	/** \brief ƥʵ鹲 */
+	PatchMatchStereo matcher_;
+
+	/** \brief ӰӲ */
+	uint8* tile_left_;
+	uint8* tile_right_;
+	float32* tile_disp_;
+
+	/** \brief Ƿʼ־ */
+	bool is_initialized_;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #ifndef PATCH_MATCH_STEREO_TYPES_H_
 #define PATCH_MATCH_STEREO_TYPES_H_
 
+#include <cmath>
 #include <cstdint>
 #include <limits>
 #include <vector>
@@ -43,21 +44,107 @@ struct PMSOption {
 	float32	tau_col;			// tau for color	ƶȼɫռľԲ½ضֵ
 	float32	tau_grad;			// tau for gradient ƶȼݶȿռľԲ½ضֵ
 
-	sint32	num_iters;			// 
+	sint32	num_iters;			// жʱΪ
+	float32	converge_thres;		// ֵ>0ʱÿε飺ܾۺϴ۵½ƽ汻µرСڸֵʱǰ
 
 	bool	is_check_lr;		// Ƿһ
 	float32	lrcheck_thres;		// һԼֵ
 
 	bool	is_fill_holes;		// ǷӲն
+	sint32	median_filter;		// Ӳֵ˲ 0-Ȩֵȷѡ 1-ڻֱͼļȨֵƣ 2-ʱֵȨӲ
 
 	bool	is_fource_fpw;		// ǷǿΪFrontal-Parallel Window
 	bool	is_integer_disp;	// ǷΪӲ
+
+	sint32	num_threads;		// ߳<=0ʱȡӲ߳
+	bool	is_redblack_propagation;	// Ƿú̸дΪ˳򴫲
+	bool	is_concurrent_views;	// Ƿͼ߳ϲͼnum_threadsһ
+	bool	is_active_set;		// Ƿ״εֻϴεƽ汻µأƽδ仯ظŻ
+	float32	active_thres;		// Ϊƽб仯С½ڸֵĸԱܵ
+
+	uint32	seed;				// ӣͬӵĽɸ֣߳޹أ0ʾÿƥ
+
+	sint32	simd_level;			// ۼʹõSIMD 0- 1-AVX2 2-AVX512ʵʼ𲻳CPUֵ֧ļ
+
+	bool	is_fixed_point;		// Ƿʹ16λۼֵۼӣΪ汾ĽֵȡֵΧʱԶʹø汾
+
+	sint32	subpixel_factor;	// Ӱˮƽ48>1ʱÿƥǰɳɫݶƽ棬ֱͬӶȡ<=1ʱʵʱԲֵۼʹã
+
+	sint32	sample_step;		// ڲΪ׼ÿsample_stepСȡһأ1Ϊܴڣ2ʱԼΪ1/4
+
+	float32	refine_range;		// ƽŻĳʼӲŶΧأ<=0ʱȡӲΧһ룬ŶΧͬС
+
+	sint32	pyramid_levels;		// 1Ϊ߶ƥ䣻>1ʱֲƥ䣬ϲӲƽΪϸһĳֵ
+	sint32	pyramid_iters;		// ֲĴ
+	float32	pyramid_refine_range;	// ֲƽŻʼӲŶΧأ
+
+	bool	is_temporal;		// ǷΪƵģʽһ֡ӲƽΪǰ֡ĳֵ
+	sint32	temporal_iters;		// ֡Ĵ
+	float32	temporal_refine_range;	// ֡ƽŻʼӲŶΧأ
+	float32	temporal_rerandom_ratio;	// ʱʼر[0,1]µĺѡƽ
+
+	bool	is_mapped_storage;	// ƽ漰ǷڴӳʱļӰʱڴռãϵͳ軻뻻
+	const char* storage_dir;	// ڴӳʱļĿ¼nullptrʱΪϵͳʱĿ¼
 	
 	PMSOption() : patch_size(35), min_disparity(0), max_disparity(64), gamma(10.0f), alpha(0.9f), tau_col(10.0f),
-	              tau_grad(2.0f), num_iters(3),
+	              tau_grad(2.0f), num_iters(3), converge_thres(0.0f),
 	              is_check_lr(false),
 	              lrcheck_thres(0),
-	              is_fill_holes(false), is_fource_fpw(false), is_integer_disp(false) { }
+	              is_fill_holes(false), median_filter(0), is_fource_fpw(false), is_integer_disp(false),
+	              num_threads(0), is_redblack_propagation(false), is_concurrent_views(false), is_active_set(false), active_thres(0.03f),
+	              seed(0), simd_level(2), is_fixed_point(false), subpixel_factor(1), sample_step(1), refine_range(0.0f),
+	              pyramid_levels(1), pyramid_iters(2), pyramid_refine_range(2.0f),
+	              is_temporal(false), temporal_iters(1), temporal_refine_range(1.0f), temporal_rerandom_ratio(0.05f),
+	              is_mapped_storage(false), storage_dir(nullptr) { }
+};
+
+/** \brief  */
+struct PMSCounters {
+	uint64	num_compute_a;		// ۺϴۼѡƽƣ
+	uint64	num_samples;		// ۼӵĴڲѡƽ֮ͣǰֹвƣ
+	uint64	num_spatial_updates;	// ռ䴫ܵƽ´
+	uint64	num_view_updates;	// ͼܵƽ´
+	uint64	num_refine_updates;	// ƽŻܵƽ´
+	uint64	num_changed_pixels;	// ʱƽ汻ռ䴫ƽŻµÿηһΣ
+	uint64	num_visited_pixels;	// ʵʱزƣ
+
+	PMSCounters() : num_compute_a(0), num_samples(0), num_spatial_updates(0), num_view_updates(0), num_refine_updates(0),
+	                num_changed_pixels(0), num_visited_pixels(0) { }
+
+	PMSCounters& operator+=(const PMSCounters& c) {
+		num_compute_a += c.num_compute_a;
+		num_samples += c.num_samples;
+		num_spatial_updates += c.num_spatial_updates;
+		num_view_updates += c.num_view_updates;
+		num_refine_updates += c.num_refine_updates;
+		num_changed_pixels += c.num_changed_pixels;
+		num_visited_pixels += c.num_visited_pixels;
+		return *this;
+	}
+};
+
+/** \brief ƥͳϢ׶κʱ룩ÿƥ¼¼ */
+struct PMSStatistics {
+	float64	time_init;			// ƽʼʱʼʼֲƥ估ϲ
+	float64	time_gray;			// Ҷͼʱ
+	float64	time_gradient;		// ݶͼʱ
+	float64	time_planar;		// ɷͨݺʱ
+	float64	time_cost_init;		// ǰʼۺʱ
+	vector<float64> time_iter_left;		// ͼÿεĴʱ
+	vector<float64> time_iter_right;	// ͼÿεĴʱͼʱͼص
+	vector<float64> iter_changed_ratio;	// ÿεƽ汻µرͼϼƣ
+	vector<float64> iter_active_ratio;	// ÿεбʵرͼϼƣʱΪ1
+	vector<float64> iter_cost;			// ÿεͼܾۺϴۣ׸ԪΪǰĳʼֵ
+	float64	time_plane_to_disp;	// ƽתΪӲʱ
+	float64	time_lr_check;		// һԼʱ
+	float64	time_fill_holes;	// Ӳʱ
+	float64	time_total;			// ƥܺʱ
+
+	PMSCounters counters_left;	// ͼʼۼ㣩
+	PMSCounters counters_right;	// ͼ
+
+	PMSStatistics() : time_init(0), time_gray(0), time_gradient(0), time_planar(0), time_cost_init(0),
+	                  time_plane_to_disp(0), time_lr_check(0), time_fill_holes(0), time_total(0) { }
 };
 
 /**
@@ -247,6 +334,28 @@ struct DisparityPlane {
 		return { p.x * denom, p.y * denom, p.z * denom };
 	}
 
+	/**
+	 * \brief Ӳƽƽ(dx,dy)ƽƺ(x,y)Ӳԭ(x-dx,y-dy)Ӳ
+	 * \param dx	xƽ
+	 * \param dy	yƽ
+	 * \return ƽƺƽ
+	 */
+	DisparityPlane to_translated(const float32& dx, const float32& dy) const
+	{
+		return { p.x, p.y, p.z - p.x * dx - p.y * dy };
+	}
+
+	/**
+	 * \brief Ӳƽת2ֱʵӰ񣨽һ㣩
+	 * ֲ(xc,yc)ĶӦϸ x = 2*xc + 0.5Ӳ֮Ŵ2
+	 * ƽ淽̵ϸƽ: d = a_p*x + b_p*y + 2*c_p - (a_p+b_p)/2
+	 * \return תƽ
+	 */
+	DisparityPlane to_finer_level() const
+	{
+		return { p.x, p.y, 2.0f * p.z - 0.5f * (p.x + p.y) };
+	}
+
 	// operator ==
 	bool operator==(const DisparityPlane& v) const {
 		return p == v.p;
@@ -8,6 +8,10 @@
 #include "pms_util.h"
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <cstdlib>
 
 PColor pms_util::GetColor(const uint8* img_data, const sint32& width, const sint32& height, const sint32& x, const sint32& y)
 {
@@ -104,4 +108,616 @@ void pms_util::WeightedMedianFilter(const uint8* img_data, const sint32& width,
 	}
 }
 
+namespace {
+	/** \brief ֱͼֵ˲ֱͼߴ磺ּÿּڵϸ */
+	constexpr sint32 Hist_Coarse = 32;
+	constexpr sint32 Hist_Fine = 32;
+	constexpr sint32 Hist_Bins = Hist_Coarse * Hist_Fine;
 
+	/**
+	 * \brief ͳЧֵInvalid_FloatȡֵΧ
+	 * \return ǷЧֵ
+	 */
+	bool ValidRange(const float32* data, const sint32& num, float32& v_min, float32& v_max)
+	{
+		v_min = std::numeric_limits<float32>::max();
+		v_max = -std::numeric_limits<float32>::max();
+		for (sint32 i = 0; i < num; i++) {
+			const float32 v = data[i];
+			if (v != Invalid_Float) {
+				v_min = std::min(v_min, v);
+				v_max = std::max(v_max, v);
+			}
+		}
+		return v_min <= v_max;
+	}
+}
+
+namespace {
+	/** \brief ֱͼÿͨɫλɫӲֱͼĴּÿּڵϸ */
+	constexpr sint32 Joint_Color_Bits = 4;
+	constexpr sint32 Joint_Features = 1 << (3 * Joint_Color_Bits);
+	constexpr sint32 Joint_Coarse = 16;
+	constexpr sint32 Joint_Fine = 16;
+	constexpr sint32 Joint_Bins = Joint_Coarse * Joint_Fine;
+	/** \brief ЧӲصı */
+	constexpr uint32 Invalid_Code = 0xFFFFFFFF;
+
+	/** \brief ɫţͨȡJoint_Color_Bitsλ */
+	inline sint32 ColorFeature(const uint8* col)
+	{
+		constexpr sint32 shift = 8 - Joint_Color_Bits;
+		return ((col[0] >> shift) << (2 * Joint_Color_Bits)) | ((col[1] >> shift) << Joint_Color_Bits) | (col[2] >> shift);
+	}
+}
+
+void pms_util::WeightedMedianFilterHist(const uint8* img_data, const sint32& width, const sint32& height, const sint32& wnd_size, const float32& gamma, const vector<pair<int, int>>& filter_pixels, float32* disparity_map)
+{
+	if (img_data == nullptr || disparity_map == nullptr || filter_pixels.empty()) {
+		return;
+	}
+
+	// ȨֵֻɫйأɫΪԤȼȫȡֵ
+	float32 weight_lut[3 * 255 + 1];
+	for (sint32 dc = 0; dc <= 3 * 255; dc++) {
+		weight_lut[dc] = exp(-dc / gamma);
+	}
+	JointHistParams params;
+	if (!PrepareJointHist(img_data, disparity_map, width, height, wnd_size, weight_lut, params)) {
+		return;
+	}
+
+	// ˳ͬһеλ
+	const sint32 num = static_cast<sint32>(filter_pixels.size());
+	vector<pair<int, int>> pixels(filter_pixels);
+	std::sort(pixels.begin(), pixels.end(), [](const pair<int, int>& a, const pair<int, int>& b) {
+		return a.second < b.second || (a.second == b.second && a.first < b.first);
+	});
+
+	// ݴ棬ȫͳһд
+	vector<float32> results(num);
+	JointHistogram hist;
+	for (sint32 begin = 0; begin < num;) {
+		sint32 end = begin + 1;
+		while (end < num && pixels[end].second == pixels[begin].second) {
+			end++;
+		}
+		hist.FilterRow(params, &pixels[begin], end - begin, &results[begin]);
+		begin = end;
+	}
+	for (sint32 n = 0; n < num; n++) {
+		disparity_map[pixels[n].second * width + pixels[n].first] = results[n];
+	}
+}
+
+bool pms_util::PrepareJointHist(const uint8* img_data, const float32* disparity_map, const sint32& width, const sint32& height, const sint32& wnd_size, const float32* weight_lut, JointHistParams& params)
+{
+	if (img_data == nullptr || disparity_map == nullptr || weight_lut == nullptr || width <= 0 || height <= 0) {
+		return false;
+	}
+	float32 d_min, d_max;
+	if (!ValidRange(disparity_map, width * height, d_min, d_max)) {
+		return false;
+	}
+	params.img_data = img_data;
+	params.disparity_map = disparity_map;
+	params.width = width;
+	params.height = height;
+	params.wnd_size = wnd_size;
+	params.weight_lut = weight_lut;
+
+	// Ӳ[0,Joint_Bins)
+	params.d_min = d_min;
+	params.scale = (d_max > d_min) ? (Joint_Bins - 1) / (d_max - d_min) : 0.0f;
+
+	// ڴڻʱɾԤȼ루ɫӲͬʱͳƸɫƽɫΪɫ
+	const sint32 num = width * height;
+	params.codes.resize(num);
+	vector<sint32> counts(Joint_Features, 0);
+	vector<sint64> sums(Joint_Features * 3, 0);
+	for (sint32 i = 0; i < num; i++) {
+		const uint8* col = img_data + i * 3;
+		const sint32 f = ColorFeature(col);
+		counts[f]++;
+		sums[f * 3] += col[0];
+		sums[f * 3 + 1] += col[1];
+		sums[f * 3 + 2] += col[2];
+
+		const float32 d = disparity_map[i];
+		if (d == Invalid_Float) {
+			params.codes[i] = Invalid_Code;
+			continue;
+		}
+		const sint32 bin = std::min(static_cast<sint32>((d - d_min) * params.scale), Joint_Bins - 1);
+		params.codes[i] = static_cast<uint32>(f * Joint_Bins + bin);
+	}
+
+	// Ӱδֵȡ
+	constexpr sint32 shift = 8 - Joint_Color_Bits;
+	params.feature_colors.resize(Joint_Features * 3);
+	for (sint32 f = 0; f < Joint_Features; f++) {
+		for (sint32 k = 0; k < 3; k++) {
+			const sint32 level = (f >> ((2 - k) * Joint_Color_Bits)) & ((1 << Joint_Color_Bits) - 1);
+			params.feature_colors[f * 3 + k] = static_cast<uint8>(counts[f] > 0 ?
+				(sums[f * 3 + k] + counts[f] / 2) / counts[f] : (level << shift) + (1 << (shift - 1)));
+		}
+	}
+	return true;
+}
+
+void pms_util::JointHistogram::FilterRow(const JointHistParams& params, const pair<int, int>* pixels, const sint32& num, float32* results)
+{
+	if (num <= 0) {
+		return;
+	}
+	if (feature_slot_.empty()) {
+		feature_slot_.assign(Joint_Features, -1);
+	}
+	const sint32 width = params.width;
+	const sint32 wnd_size2 = params.wnd_size / 2;
+	const sint32 y = pixels[0].second;
+	const sint32 y0 = std::max(y - wnd_size2, 0), y1 = std::min(y + wnd_size2, params.height - 1);
+
+	// ǰڵзΧ[wx0,wx1]ʼΪ
+	sint32 wx0 = 0, wx1 = -1;
+	for (sint32 n = 0; n < num; n++) {
+		const sint32 x = pixels[n].first;
+		const sint32 nx0 = std::max(x - wnd_size2, 0), nx1 = std::min(x + wnd_size2, width - 1);
+
+		// ֻɾ¾ɴڲصУذxʱÿɾΪصļ
+		for (sint32 xc = wx0; xc <= std::min(wx1, nx0 - 1); xc++) {
+			UpdateColumn(params, xc, y0, y1, -1);
+		}
+		for (sint32 xc = std::max(wx0, nx1 + 1); xc <= wx1; xc++) {
+			UpdateColumn(params, xc, y0, y1, -1);
+		}
+		for (sint32 xc = nx0; xc <= std::min(nx1, wx0 - 1); xc++) {
+			UpdateColumn(params, xc, y0, y1, 1);
+		}
+		for (sint32 xc = std::max(nx0, wx1 + 1); xc <= nx1; xc++) {
+			UpdateColumn(params, xc, y0, y1, 1);
+		}
+		wx0 = nx0;
+		wx1 = nx1;
+
+		results[n] = params.disparity_map[y * width + x];
+		Query(params, params.img_data + (y * width + x) * 3, results[n]);
+	}
+
+	// ƳڵȫУԱ㸴
+	for (sint32 xc = wx0; xc <= wx1; xc++) {
+		UpdateColumn(params, xc, y0, y1, -1);
+	}
+}
+
+sint64 pms_util::JointHistogram::EstimateMemory(const sint32& wnd_size)
+{
+	// ֱͼ
+	const sint64 num_slots = std::min<sint64>(Joint_Features, static_cast<sint64>(wnd_size) * wnd_size);
+	const sint64 slot_bytes = 4 * sizeof(sint32) + 3 * sizeof(uint8) + sizeof(float32) +
+		Joint_Coarse * sizeof(uint16) + Joint_Bins * (sizeof(uint16) + sizeof(float32));
+	return Joint_Features * sizeof(sint32) + num_slots * slot_bytes;
+}
+
+void pms_util::JointHistogram::UpdateColumn(const JointHistParams& params, const sint32& x, const sint32& y0, const sint32& y1, const sint32& sign)
+{
+	const sint32 width = params.width;
+	for (sint32 yr = y0; yr <= y1; yr++) {
+		const uint32 code = params.codes[yr * width + x];
+		if (code == Invalid_Code) {
+			continue;
+		}
+		const float32 d = params.disparity_map[yr * width + x];
+		const sint32 f = static_cast<sint32>(code / Joint_Bins);
+		const sint32 bin = static_cast<sint32>(code % Joint_Bins);
+
+		// ״ν봰ʱֱͼȸÿеֱͼ
+		sint32 slot = feature_slot_[f];
+		if (slot < 0) {
+			if (!free_.empty()) {
+				slot = free_.back();
+				free_.pop_back();
+			}
+			else {
+				slot = static_cast<sint32>(slot_count_.size());
+				slot_count_.push_back(0);
+				slot_color_.resize(slot_color_.size() + 3);
+				coarse_.resize(coarse_.size() + Joint_Coarse, 0);
+				fine_.resize(fine_.size() + Joint_Bins, 0);
+				sums_.resize(sums_.size() + Joint_Bins, 0.0f);
+				active_pos_.push_back(0);
+			}
+			feature_slot_[f] = slot;
+			for (sint32 k = 0; k < 3; k++) {
+				slot_color_[slot * 3 + k] = params.feature_colors[f * 3 + k];
+			}
+			active_pos_[slot] = static_cast<sint32>(active_.size());
+			active_.push_back(slot);
+		}
+
+		slot_count_[slot] += sign;
+		coarse_[slot * Joint_Coarse + bin / Joint_Fine] += sign;
+		uint16& count = fine_[slot * Joint_Bins + bin];
+		count += sign;
+		// ʱӲֱ֮㣬ۻ
+		sums_[slot * Joint_Bins + bin] = (count == 0) ? 0.0f : sums_[slot * Joint_Bins + bin] + sign * d;
+
+		// Ƴʱͷֱͼ
+		if (slot_count_[slot] == 0) {
+			feature_slot_[f] = -1;
+			const sint32 last = active_.back();
+			active_[active_pos_[slot]] = last;
+			active_pos_[last] = active_pos_[slot];
+			active_.pop_back();
+			free_.push_back(slot);
+		}
+	}
+}
+
+bool pms_util::JointHistogram::Query(const JointHistParams& params, const uint8* col_p, float32& result)
+{
+	const sint32 num_active = static_cast<sint32>(active_.size());
+	if (num_active == 0) {
+		return false;
+	}
+
+	// ȨֵּۼӵȨֵ
+	weights_.resize(num_active);
+	float32 hist_coarse[Joint_Coarse] = {};
+	for (sint32 i = 0; i < num_active; i++) {
+		const sint32 slot = active_[i];
+		const uint8* col_q = &slot_color_[slot * 3];
+		const sint32 dc = abs(col_p[0] - col_q[0]) + abs(col_p[1] - col_q[1]) + abs(col_p[2] - col_q[2]);
+		const float32 w = params.weight_lut[dc];
+		weights_[i] = w;
+		const uint16* counts = &coarse_[slot * Joint_Coarse];
+		for (sint32 c = 0; c < Joint_Coarse; c++) {
+			hist_coarse[c] += w * counts[c];
+		}
+	}
+	float32 total_w = 0.0f;
+	for (sint32 c = 0; c < Joint_Coarse; c++) {
+		total_w += hist_coarse[c];
+	}
+	const float32 median_w = total_w / 2;
+
+	// λۻȨֵ״δﵽһĴּ䣬δﵽʱȡһǿ䣻accΪ֮ǰۻȨֵ
+	sint32 coarse = -1;
+	float32 acc = 0.0f, acc_coarse = 0.0f;
+	for (sint32 c = 0; c < Joint_Coarse; c++) {
+		if (hist_coarse[c] <= 0.0f) {
+			continue;
+		}
+		coarse = c;
+		acc_coarse = acc;
+		if (acc + hist_coarse[c] >= median_w) {
+			break;
+		}
+		acc += hist_coarse[c];
+	}
+	if (coarse < 0) {
+		return false;
+	}
+
+	// ּڰϸۼȨֵȨӲ
+	float32 hist_fine[Joint_Fine] = {};
+	float32 hist_disp[Joint_Fine] = {};
+	for (sint32 i = 0; i < num_active; i++) {
+		const sint32 offset = active_[i] * Joint_Bins + coarse * Joint_Fine;
+		const uint16* counts = &fine_[offset];
+		const float32* sums = &sums_[offset];
+		const float32 w = weights_[i];
+		for (sint32 k = 0; k < Joint_Fine; k++) {
+			hist_fine[k] += w * counts[k];
+			hist_disp[k] += w * sums[k];
+		}
+	}
+	sint32 fine = -1;
+	acc = acc_coarse;
+	for (sint32 k = 0; k < Joint_Fine; k++) {
+		if (hist_fine[k] <= 0.0f) {
+			continue;
+		}
+		fine = k;
+		if (acc + hist_fine[k] >= median_w) {
+			break;
+		}
+		acc += hist_fine[k];
+	}
+	if (fine < 0) {
+		return false;
+	}
+
+	// ֵӲļȨֵ
+	result = hist_disp[fine] / hist_fine[fine];
+	return true;
+}
+
+void pms_util::MedianFilterO1(const float32* in, float32* out, const sint32& width, const sint32& height, const sint32 wnd_size)
+{
+	if (in == nullptr || out == nullptr || width <= 0 || height <= 0) {
+		return;
+	}
+	const sint32 radius = wnd_size / 2;
+	const sint32 num = width * height;
+
+	// Чֵ[0,Hist_Bins-1)ЧֵΪһ
+	constexpr sint32 Invalid_Bin = Hist_Bins - 1;
+	float32 v_min = 0.0f, v_max = 0.0f;
+	ValidRange(in, num, v_min, v_max);
+	const float32 scale = (v_max > v_min) ? (Invalid_Bin - 1) / (v_max - v_min) : 0.0f;
+	const float32 step = (scale > 0.0f) ? 1.0f / scale : 0.0f;
+	vector<uint16> bins(num);
+	for (sint32 i = 0; i < num; i++) {
+		bins[i] = (in[i] == Invalid_Float) ? Invalid_Bin :
+			static_cast<uint16>(std::min(static_cast<sint32>((in[i] - v_min) * scale), Invalid_Bin - 1));
+	}
+
+	// еֱͼǵǰеĴ
+	vector<uint16> col_fine(static_cast<size_t>(width) * Hist_Bins, 0);
+	vector<uint16> col_coarse(static_cast<size_t>(width) * Hist_Coarse, 0);
+	const auto update_row = [&](const sint32& row, const sint32& delta) {
+		const uint16* bin_row = &bins[row * width];
+		for (sint32 x = 0; x < width; x++) {
+			col_fine[x * Hist_Bins + bin_row[x]] += delta;
+			col_coarse[x * Hist_Coarse + bin_row[x] / Hist_Fine] += delta;
+		}
+	};
+
+	// ֱͼּ洰ڻÿ£ϸֵֻôּʱͬǰλ
+	vector<sint32> kernel_coarse(Hist_Coarse);
+	vector<sint32> kernel_fine(Hist_Bins);
+	vector<sint32> fine_x(Hist_Coarse);
+	const auto update_fine = [&](const sint32& c, const sint32& col, const sint32& delta) {
+		const uint16* src = &col_fine[col * Hist_Bins + c * Hist_Fine];
+		sint32* dst = &kernel_fine[c * Hist_Fine];
+		for (sint32 f = 0; f < Hist_Fine; f++) {
+			dst[f] += delta * src[f];
+		}
+	};
+
+	for (sint32 y = 0; y < height; y++) {
+		// ֱͼһ
+		if (y == 0) {
+			for (sint32 row = 0; row <= std::min(radius, height - 1); row++) {
+				update_row(row, 1);
+			}
+		}
+		else {
+			if (y - radius - 1 >= 0) {
+				update_row(y - radius - 1, -1);
+			}
+			if (y + radius < height) {
+				update_row(y + radius, 1);
+			}
+		}
+		const sint32 rows = std::min(y + radius, height - 1) - std::max(y - radius, 0) + 1;
+
+		// ÿпʼʱؽڵĴֱּͼϸȫΪؽ
+		std::fill(kernel_coarse.begin(), kernel_coarse.end(), 0);
+		for (sint32 col = 0; col <= std::min(radius, width - 1); col++) {
+			for (sint32 c = 0; c < Hist_Coarse; c++) {
+				kernel_coarse[c] += col_coarse[col * Hist_Coarse + c];
+			}
+		}
+		std::fill(fine_x.begin(), fine_x.end(), -1);
+
+		for (sint32 x = 0; x < width; x++) {
+			if (x > 0) {
+				const sint32 col_out = x - radius - 1, col_in = x + radius;
+				for (sint32 c = 0; c < Hist_Coarse; c++) {
+					kernel_coarse[c] += ((col_in < width) ? col_coarse[col_in * Hist_Coarse + c] : 0) -
+						((col_out >= 0) ? col_coarse[col_out * Hist_Coarse + c] : 0);
+				}
+			}
+			const sint32 x0 = std::max(x - radius, 0), x1 = std::min(x + radius, width - 1);
+			const sint32 rank = rows * (x1 - x0 + 1) / 2;
+
+			// ڴֱּͼжλֵ
+			sint32 acc = 0, c = 0;
+			while (acc + kernel_coarse[c] <= rank) {
+				acc += kernel_coarse[c++];
+			}
+
+			// ͬôּϸֱͼϴͬԶʱؽ
+			if (fine_x[c] < 0 || x - fine_x[c] > x1 - x0 + 1) {
+				std::fill(kernel_fine.begin() + c * Hist_Fine, kernel_fine.begin() + (c + 1) * Hist_Fine, 0);
+				for (sint32 col = x0; col <= x1; col++) {
+					update_fine(c, col, 1);
+				}
+			}
+			else {
+				for (sint32 xs = fine_x[c] + 1; xs <= x; xs++) {
+					if (xs - radius - 1 >= 0) {
+						update_fine(c, xs - radius - 1, -1);
+					}
+					if (xs + radius < width) {
+						update_fine(c, xs + radius, 1);
+					}
+				}
+			}
+			fine_x[c] = x;
+
+			// ϸֱͼжλֵ
+			sint32 bin = c * Hist_Fine;
+			while (acc + kernel_fine[bin] <= rank) {
+				acc += kernel_fine[bin++];
+			}
+			out[y * width + x] = (bin == Invalid_Bin) ? Invalid_Float : std::min(v_min + (bin + 0.5f) * step, v_max);
+		}
+	}
+}
+
+void pms_util::ComputeGray(const uint8* color, const sint32& width, const sint32& height, uint8* gray)
+{
+	if (color == nullptr || gray == nullptr) {
+		return;
+	}
+	for (sint32 i = 0; i < height; i++) {
+		for (sint32 j = 0; j < width; j++) {
+			const auto b = color[i * width * 3 + 3 * j];
+			const auto g = color[i * width * 3 + 3 * j + 1];
+			const auto r = color[i * width * 3 + 3 * j + 2];
+			gray[i * width + j] = uint8(r * 0.299 + g * 0.587 + b * 0.114);
+		}
+	}
+}
+
+void pms_util::ComputeGradient(const uint8* gray, const sint32& width, const sint32& height, PGradient* grad)
+{
+	if (gray == nullptr || grad == nullptr) {
+		return;
+	}
+	for (int y = 1; y < height - 1; y++) {
+		for (int x = 1; x < width - 1; x++) {
+			const auto grad_x = (-gray[(y - 1) * width + x - 1] + gray[(y - 1) * width + x + 1]) +
+				(-2 * gray[y * width + x - 1] + 2 * gray[y * width + x + 1]) +
+				(-gray[(y + 1) * width + x - 1] + gray[(y + 1) * width + x + 1]);
+			const auto grad_y = (-gray[(y - 1) * width + x - 1] - 2 * gray[(y - 1) * width + x] - gray[(y - 1) * width + x + 1]) +
+				(gray[(y + 1) * width + x - 1] + 2 * gray[(y + 1) * width + x] + gray[(y + 1) * width + x + 1]);
+
+			// 8Ϊݶȵֵ255ʱݶȲɫλͬһ߶
+			grad[y * width + x].x = grad_x / 8;
+			grad[y * width + x].y = grad_y / 8;
+		}
+	}
+}
+
+void pms_util::DownsampleImage(const uint8* src, const sint32& width, const sint32& height, uint8* dst)
+{
+	if (src == nullptr || dst == nullptr || width <= 0 || height <= 0) {
+		return;
+	}
+	const sint32 width_dst = (width + 1) / 2;
+	const sint32 height_dst = (height + 1) / 2;
+	for (sint32 y = 0; y < height_dst; y++) {
+		const sint32 y1 = 2 * y;
+		const sint32 y2 = std::min(y1 + 1, height - 1);
+		for (sint32 x = 0; x < width_dst; x++) {
+			const sint32 x1 = 2 * x;
+			const sint32 x2 = std::min(x1 + 1, width - 1);
+			for (sint32 n = 0; n < 3; n++) {
+				const sint32 sum = src[y1 * width * 3 + 3 * x1 + n] + src[y1 * width * 3 + 3 * x2 + n] +
+					src[y2 * width * 3 + 3 * x1 + n] + src[y2 * width * 3 + 3 * x2 + n];
+				dst[y * width_dst * 3 + 3 * x + n] = static_cast<uint8>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool pms_util::SetOption(PMSOption& option, const std::string& key, const std::string& value)
+{
+	if (value.empty()) {
+		return false;
+	}
+	const char* str = value.c_str();
+	char* end = nullptr;
+
+	// Ͳ
+	const std::pair<const char*, sint32*> int_fields[] = {
+		{ "patch_size", &option.patch_size }, { "min_disparity", &option.min_disparity }, { "max_disparity", &option.max_disparity },
+		{ "num_iters", &option.num_iters }, { "median_filter", &option.median_filter }, { "num_threads", &option.num_threads },
+		{ "simd_level", &option.simd_level }, { "subpixel_factor", &option.subpixel_factor }, { "sample_step", &option.sample_step },
+		{ "pyramid_levels", &option.pyramid_levels }, { "pyramid_iters", &option.pyramid_iters }, { "temporal_iters", &option.temporal_iters }
+	};
+	for (const auto& field : int_fields) {
+		if (key == field.first) {
+			const long v = strtol(str, &end, 10);
+			if (*end != '\0') {
+				return false;
+			}
+			*field.second = static_cast<sint32>(v);
+			return true;
+		}
+	}
+	if (key == "seed") {
+		const unsigned long v = strtoul(str, &end, 10);
+		if (*end != '\0') {
+			return false;
+		}
+		option.seed = static_cast<uint32>(v);
+		return true;
+	}
+
+	// 
+	const std::pair<const char*, float32*> float_fields[] = {
+		{ "gamma", &option.gamma }, { "alpha", &option.alpha }, { "tau_col", &option.tau_col }, { "tau_grad", &option.tau_grad },
+		{ "converge_thres", &option.converge_thres }, { "lrcheck_thres", &option.lrcheck_thres }, { "active_thres", &option.active_thres },
+		{ "refine_range", &option.refine_range }, { "pyramid_refine_range", &option.pyramid_refine_range },
+		{ "temporal_refine_range", &option.temporal_refine_range }, { "temporal_rerandom_ratio", &option.temporal_rerandom_ratio }
+	};
+	for (const auto& field : float_fields) {
+		if (key == field.first) {
+			const float32 v = strtof(str, &end);
+			if (*end != '\0') {
+				return false;
+			}
+			*field.second = v;
+			return true;
+		}
+	}
+
+	// 
+	const std::pair<const char*, bool*> bool_fields[] = {
+		{ "is_check_lr", &option.is_check_lr }, { "is_fill_holes", &option.is_fill_holes }, { "is_fource_fpw", &option.is_fource_fpw },
+		{ "is_integer_disp", &option.is_integer_disp }, { "is_redblack_propagation", &option.is_redblack_propagation },
+		{ "is_concurrent_views", &option.is_concurrent_views }, { "is_active_set", &option.is_active_set },
+		{ "is_fixed_point", &option.is_fixed_point }, { "is_temporal", &option.is_temporal }, { "is_mapped_storage", &option.is_mapped_storage }
+	};
+	for (const auto& field : bool_fields) {
+		if (key == field.first) {
+			if (value == "1" || value == "true") {
+				*field.second = true;
+			}
+			else if (value == "0" || value == "false") {
+				*field.second = false;
+			}
+			else {
+				return false;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+sint32 pms_util::GetNumThreads(const sint32& num_threads)
+{
+	if (num_threads > 0) {
+		return num_threads;
+	}
+	const sint32 hw_threads = static_cast<sint32>(std::thread::hardware_concurrency());
+	return std::max(hw_threads, 1);
+}
+
+void pms_util::ParallelFor(const sint32& begin, const sint32& end, const sint32& num_threads,
+	const std::function<void(const sint32&, const sint32&)>& func)
+{
+	if (end <= begin) {
+		return;
+	}
+	const sint32 threads = std::min(num_threads, end - begin);
+	if (threads <= 1) {
+		for (sint32 i = begin; i < end; i++) {
+			func(i, 0);
+		}
+		return;
+	}
+
+	// ̴߳ӹж̬ȡ
+	std::atomic<sint32> next(begin);
+	auto worker = [&](const sint32 tid) {
+		for (sint32 i = next++; i < end; i = next++) {
+			func(i, tid);
+		}
+	};
+	vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (sint32 t = 1; t < threads; t++) {
+		pool.emplace_back(worker, t);
+	}
+	worker(0);
+	for (auto& th : pool) {
+		th.join();
+	}
+}
@@ -6,6 +6,9 @@
 
 #pragma once
 #include "pms_types.h"
+#include <chrono>
+#include <functional>
+#include <string>
 
 namespace pms_util
 {
@@ -31,6 +34,18 @@ namespace pms_util
 	 */
 	void MedianFilter(const float32* in, float32* out, const sint32& width, const sint32& height, const sint32 wnd_size);
 
+	/**
+	 * \brief ʱֵ˲ͬMedianFilter
+	 * ݰȡֵΧΪ1023ЧֵһлֱͼֱͼPerreault-Hebertÿصļ봰ڳߴ޹
+	 * Ϊֵֵ뾫ȷֵ֮һ
+	 * \param in				룬Դ
+	 * \param out				Ŀ
+	 * \param width				룬
+	 * \param height			룬߶
+	 * \param wnd_size			룬ڿ
+	 */
+	void MedianFilterO1(const float32* in, float32* out, const sint32& width, const sint32& height, const sint32 wnd_size);
+
 	/**
 	 * \brief Ȩֵ˲
 	 * \param img_data		ɫ
@@ -43,4 +58,177 @@ namespace pms_util
 	 */
 	void WeightedMedianFilter(const uint8* img_data, const sint32& width, const sint32& height, const sint32& wnd_size, const float32& gamma,const vector<pair<int, int>>& filter_pixels, float32* disparity_map);
 
+	/**
+	 * \brief ڻֱͼļȨֵ˲ͬWeightedMedianFilter
+	 * ڵЧذɫӲֱͼJointHistogramͬһеĴػʱֻɾУ
+	 * ͬһڵĴֻɾУرڡȨֵɫĴɫ㣬
+	 * ΪֵӲļȨֵΪֵ
+	 * ؾ˲ǰӲͼȡݣ봦˳޹
+	 * \param img_data		ɫ
+	 * \param width			Ӱ
+	 * \param height		Ӱ
+	 * \param wnd_size		ڴС
+	 * \param gamma			gammaֵ
+	 * \param filter_pixels Ҫ˲ؼ
+	 * \param disparity_map Ӳͼ
+	 */
+	void WeightedMedianFilterHist(const uint8* img_data, const sint32& width, const sint32& height, const sint32& wnd_size, const float32& gamma, const vector<pair<int, int>>& filter_pixels, float32* disparity_map);
+
+	/**
+	 * \brief ֱͼȨֵĹÿ˲ǰPrepareJointHist㣬ֻ߳
+	 */
+	struct JointHistParams {
+		const uint8* img_data;			// ɫ
+		const float32* disparity_map;	// ˲ǰӲͼ
+		sint32 width, height;			// Ӱ
+		sint32 wnd_size;				// ڴС
+		float32 d_min;					// Ӳ
+		float32 scale;					// Ӳ
+		const float32* weight_lut;		// ɫͨԲ֮ͣ0~765ȨֵĲұ
+		vector<uint8> feature_colors;	// ɫĴɫصƽɫ
+		vector<uint32> codes;			// صı룺ɫ*Ӳ+ӲЧӲΪ0xFFFFFFFF
+
+		JointHistParams() : img_data(nullptr), disparity_map(nullptr), width(0), height(0), wnd_size(0),
+		                    d_min(0.0f), scale(0.0f), weight_lut(nullptr) {}
+	};
+
+	/**
+	 * \brief ֱͼȨֵĹӲΧɫĴɫصı
+	 * \param img_data		ɫ
+	 * \param disparity_map ˲ǰӲͼ
+	 * \param width			Ӱ
+	 * \param height		Ӱ
+	 * \param wnd_size		ڴС
+	 * \param weight_lut	ȨֵұСΪ3*255+1˲ڼ䱣Ч
+	 * \param params		
+	 * \return ӲͼдЧӲʱtrue
+	 */
+	bool PrepareJointHist(const uint8* img_data, const float32* disparity_map, const sint32& width, const sint32& height, const sint32& wnd_size, const float32* weight_lut, JointHistParams& params);
+
+	/**
+	 * \brief ֱͼ߳״̬ڵЧذɫӲ
+	 * ɫΪÿͨ16ɫ4096ֻΪڳֱֵͼӲΪ16*16ֱͼ
+	 * ۼӸڵӲ֮͡ȨֵɫɫȨÿصļֻ봰ڵй
+	 * ÿдм㣬ڴڶ˲֮临
+	 */
+	class JointHistogram {
+	public:
+		/**
+		 * \brief ͬһڵؼȨֵ˲ذxʱֻ軬
+		 * \param params	
+		 * \param pixels	أλͬһ
+		 * \param num		
+		 * \param results	ص˲ЧӲʱΪԭӲ
+		 */
+		void FilterRow(const JointHistParams& params, const pair<int, int>* pixels, const sint32& num, float32* results);
+
+		/**
+		 * \brief 㵥ʵڴޣֽڣ
+		 * \param wnd_size		ڴС
+		 */
+		static sint64 EstimateMemory(const sint32& wnd_size);
+
+	private:
+		/** \brief ɾһУڵЧأsignΪ1ʱ룬-1ʱƳ */
+		void UpdateColumn(const JointHistParams& params, const sint32& x, const sint32& y0, const sint32& y1, const sint32& sign);
+
+		/** \brief ɫȨ󴰿ڵļȨֵЧӲʱfalse */
+		bool Query(const JointHistParams& params, const uint8* col_p, float32& result);
+
+		/** \brief ɫӦֱͼţ-1ʾڴ */
+		vector<sint32> feature_slot_;
+		/** \brief ֱͼɫ */
+		vector<sint32> slot_count_;
+		vector<uint8> slot_color_;
+		/** \brief ֱͼĴּϸϸڵӲ֮ */
+		vector<uint16> coarse_;
+		vector<uint16> fine_;
+		vector<float32> sums_;
+		/** \brief ʹеֱͼбеλãеֱͼ */
+		vector<sint32> active_;
+		vector<sint32> active_pos_;
+		vector<sint32> free_;
+		/** \brief ѯʱʹֱͼȨֵ */
+		vector<float32> weights_;
+	};
+
+	/**
+	 * \brief ɫתҶ
+	 * \param color		룬ɫݣBGR
+	 * \param width		룬Ӱ
+	 * \param height		룬Ӱ
+	 * \param gray		Ҷ
+	 */
+	void ComputeGray(const uint8* color, const sint32& width, const sint32& height, uint8* gray);
+
+	/**
+	 * \brief SobelӼݶȣ8ʹɫͬһ߶ȣ߽زֵ
+	 * \param gray		룬Ҷ
+	 * \param width		룬Ӱ
+	 * \param height		룬Ӱ
+	 * \param grad		ݶ
+	 */
+	void ComputeGradient(const uint8* gray, const sint32& width, const sint32& height, PGradient* grad);
+
+	/**
+	 * \brief 3ͨӰ2ĿȡԴӰ2x2ľֵߴʱƱ߽أ
+	 * \param src			룬ԴӰݣ3ͨ
+	 * \param width		룬ԴӰ
+	 * \param height		룬ԴӰ
+	 * \param dst			ĿӰݣߴΪ(width+1)/2 * (height+1)/2
+	 */
+	void DownsampleImage(const uint8* src, const sint32& width, const sint32& height, uint8* dst);
+
+	/**
+	 * \brief PMSOptionеһṹԱͬpatch_sizeis_fource_fpw
+	 * ȡֵΪ0/1false/truestorage_dirΪָ룬֧ͨ˺
+	 * \param option	㷨
+	 * \param key		
+	 * \param value		ֵ
+	 * \return Чȡֵʱtrueoption䲢false
+	 */
+	bool SetOption(PMSOption& option, const std::string& key, const std::string& value);
+
+	/**
+	 * \brief ȡʵʹõ߳
+	 * \param num_threads	趨߳<=0ʱȡӲ߳
+	 * \return ʵ߳Ϊ1
+	 */
+	sint32 GetNumThreads(const sint32& num_threads);
+
+	/**
+	 * \brief ִ̲߳[begin,end)ڵŶ̬߳
+	 * \param begin			ʼ
+	 * \param end			ֹţ
+	 * \param num_threads	߳<=1ʱڵ߳˳ִ
+	 * \param func			Ϊź߳(0~num_threads-1)
+	 */
+	void ParallelFor(const sint32& begin, const sint32& end, const sint32& num_threads, const std::function<void(const sint32&, const sint32&)>& func);
+
+	/**
+	 * \brief ʱʱʼʱ
+	 */
+	class Timer {
+	public:
+		Timer() : start_(std::chrono::steady_clock::now()) { }
+
+		/** \brief Կʼʱĺʱ룩 */
+		float64 Elapsed() const
+		{
+			return std::chrono::duration<float64, std::milli>(std::chrono::steady_clock::now() - start_).count();
+		}
+
+		/** \brief Կʼʱĺʱ룩¿ʼʱ */
+		float64 Restart()
+		{
+			const auto now = std::chrono::steady_clock::now();
+			const float64 ms = std::chrono::duration<float64, std::milli>(now - start_).count();
+			start_ = now;
+			return ms;
+		}
+
+	private:
+		std::chrono::steady_clock::time_point start_;
+	};
+
 }
\ No newline at end of file
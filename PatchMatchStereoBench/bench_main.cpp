@@ -0,0 +1,314 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: micro-benchmarks of the hot kernels
+*/
+
+#include "stdafx.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include "cost_computor.hpp"
+#include "pms_planar.h"
+#include "pms_postprocess.h"
+#include "pms_random.hpp"
+#include "pms_simd.h"
+#include "pms_util.h"
+
+/**
+ * ȵ㺯΢׼ԣJSONʽڸٸ汾ܱ仯
+ * ÷PatchMatchStereoBench [width] [height] [min_ms] [simd_level] [output.json]
+ *   width/height	ϳӰߴ磬Ĭ640x480
+ *   min_ms			ÿԵܺʱ룩Ĭ200
+ *   simd_level		ۼSIMDĬΪCPUֵ֧߼
+ *   output.json	ļȱʡʱֻ׼
+ * ÿظִܺʱmin_msҲ3Σȡ̺ʱ
+ * ns_per_pixelΪκʱԴsamples_per_secΪÿۼӵĴڲۺϴ۲ԣ
+ */
+
+namespace {
+	/** \brief Խ */
+	struct BenchResult {
+		std::string name;		// 
+		sint32 patch_size;		// ڳߴ磬봰޹ʱΪ0
+		std::string plane;		// ƽ fpw-ǰƽ slanted-бƽ޹ʱΪ
+		float64 ns_per_pixel;	// ÿغʱ룩
+		float64 samples_per_sec;	// ÿۼӵĴڲǾۺϴ۲Ϊ0
+		sint32 reps;			// ظ
+	};
+
+	/**
+	 * \brief ظִfuncֱܺʱmin_msҲ3
+	 * \param setup		ÿִǰ׼ʱΪ
+	 * \param func		⺯
+	 * \param min_ms	ܺʱ룩
+	 * \param reps		ظ
+	 * \return ̺ʱ룩
+	 */
+	float64 Measure(const std::function<void()>& setup, const std::function<void()>& func, const float64& min_ms, sint32& reps)
+	{
+		float64 best = std::numeric_limits<float64>::max();
+		float64 total = 0.0;
+		reps = 0;
+		while (reps < 3 || total < min_ms) {
+			if (setup) {
+				setup();
+			}
+			const pms_util::Timer timer;
+			func();
+			const float64 ms = timer.Elapsed();
+			best = std::min(best, ms);
+			total += ms;
+			reps++;
+		}
+		return best * 1e6;
+	}
+
+	/** \brief ϳӲ1624бƽ */
+	inline float32 SyntheticDisparity(const sint32& x, const sint32& width)
+	{
+		return 16.0f + 8.0f * x / width;
+	}
+
+	/**
+	 * \brief ɺϳԣӰΪ߶Ӱ񰴺ϳӲƽƣԲֵ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param left		ӰBGR
+	 * \param right		ӰBGR
+	 */
+	void SyntheticPair(const sint32& width, const sint32& height, vector<uint8>& left, vector<uint8>& right)
+	{
+		const auto texture = [](const float32& x, const sint32& y, const sint32& c) {
+			const float32 v = 128.0f + 50.0f * sin(x * 0.21f + c) * cos(y * 0.17f) + 30.0f * sin(x * 0.053f - y * 0.071f + 2.0f * c) +
+				20.0f * static_cast<float32>(PMSRandom::Mix(static_cast<uint64>(floor(x)) * 7919 + y * 104729 + c) % 256) / 255.0f;
+			return static_cast<uint8>(std::max(0.0f, std::min(255.0f, v)));
+		};
+		left.resize(width * height * 3);
+		right.resize(width * height * 3);
+		for (sint32 y = 0; y < height; y++) {
+			for (sint32 x = 0; x < width; x++) {
+				const float32 xl = x + SyntheticDisparity(x, width);
+				const float32 fx = xl - floor(xl);
+				for (sint32 c = 0; c < 3; c++) {
+					left[(y * width + x) * 3 + c] = texture(static_cast<float32>(x), y, c);
+					right[(y * width + x) * 3 + c] = static_cast<uint8>((1.0f - fx) * texture(floor(xl), y, c) + fx * texture(floor(xl) + 1.0f, y, c) + 0.5f);
+				}
+			}
+		}
+	}
+
+	/**
+	 * \brief ۺϴ۲ԣмһдڵظһεƽۺϴ
+	 * ȨֵֵӰ˺ʱظͬһڲصĴȨֵõComputeAĺʱ
+	 */
+	template <sint32 PATCH>
+	BenchResult BenchComputeA(const CostComputerPMS& cost_cpt, const sint32& width, const sint32& height, const bool& is_slanted, const float64& min_ms)
+	{
+		const sint32 band_rows = 16;
+		const sint32 y0 = (height - band_rows) / 2;
+		vector<float32> weights(CostComputerPMS::WeightsSize(PATCH));
+		cost_cpt.ComputeWeights<PATCH>(width / 2, height / 2, &weights[0]);
+
+		// ǰƽƽȡϳӲбƽȡϳӲһµƽ棨aΪӲˮƽݶȣ
+		vector<DisparityPlane> planes(width * band_rows);
+		for (sint32 i = 0; i < band_rows; i++) {
+			for (sint32 x = 0; x < width; x++) {
+				const float32 a = is_slanted ? 8.0f / width : 0.0f;
+				const float32 b = is_slanted ? 0.01f : 0.0f;
+				planes[i * width + x] = DisparityPlane(a, b, SyntheticDisparity(x, width) - a * x - b * (y0 + i));
+			}
+		}
+
+		sint64 samples = 0;
+		sint32 reps = 0;
+		const float64 ns = Measure(nullptr, [&]() {
+			samples = 0;
+			float32 cost;
+			for (sint32 i = 0; i < band_rows; i++) {
+				for (sint32 x = 0; x < width; x++) {
+					samples += cost_cpt.ComputeA<PATCH>(x, y0 + i, &planes[i * width + x], 1, &weights[0], &cost);
+				}
+			}
+		}, min_ms, reps);
+		return { "compute_a", PATCH, is_slanted ? "slanted" : "fpw", ns / (width * band_rows), samples / (ns * 1e-9), reps };
+	}
+
+	/** \brief JSONʽĽ */
+	void WriteJson(FILE* fp, const sint32& width, const sint32& height, const sint32& simd_level, const vector<BenchResult>& results)
+	{
+		fprintf(fp, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"simd_level\": %d,\n  \"benchmarks\": [\n", width, height, simd_level);
+		for (size_t n = 0; n < results.size(); n++) {
+			const auto& r = results[n];
+			fprintf(fp, "    {\"name\": \"%s\", \"patch_size\": %d, \"plane\": \"%s\", \"ns_per_pixel\": %.4f, \"samples_per_sec\": %.6g, \"reps\": %d}%s\n",
+				r.name.c_str(), r.patch_size, r.plane.c_str(), r.ns_per_pixel, r.samples_per_sec, r.reps, n + 1 < results.size() ? "," : "");
+		}
+		fprintf(fp, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const sint32 width = (argc > 1) ? atoi(argv[1]) : 640;
+	const sint32 height = (argc > 2) ? atoi(argv[2]) : 480;
+	const float64 min_ms = (argc > 3) ? atof(argv[3]) : 200.0;
+	const sint32 simd_level = std::min((argc > 4) ? atoi(argv[4]) : static_cast<sint32>(PMS_SIMD_AVX512), pms_simd::GetCpuSimdLevel());
+	const char* output = (argc > 5) ? argv[5] : nullptr;
+	if (width < 64 || height < 64 || min_ms <= 0.0) {
+		fprintf(stderr, "usage: %s [width>=64] [height>=64] [min_ms] [simd_level] [output.json]\n", argv[0]);
+		return -1;
+	}
+	const sint32 num_pixels = width * height;
+	const sint32 min_disp = 0, max_disp = 64;
+
+	// ϳԼҶȡݶȡͨ
+	vector<uint8> img_left, img_right;
+	SyntheticPair(width, height, img_left, img_right);
+	vector<uint8> gray_left(num_pixels), gray_right(num_pixels);
+	vector<PGradient> grad_left(num_pixels), grad_right(num_pixels);
+	pms_util::ComputeGray(&img_left[0], width, height, &gray_left[0]);
+	pms_util::ComputeGray(&img_right[0], width, height, &gray_right[0]);
+	pms_util::ComputeGradient(&gray_left[0], width, height, &grad_left[0]);
+	pms_util::ComputeGradient(&gray_right[0], width, height, &grad_right[0]);
+
+	vector<BenchResult> results;
+	sint32 reps = 0;
+	float64 ns = 0.0;
+
+	// ɫתҶȡݶ
+	ns = Measure(nullptr, [&]() { pms_util::ComputeGray(&img_left[0], width, height, &gray_left[0]); }, min_ms, reps);
+	results.push_back({ "compute_gray", 0, "", ns / num_pixels, 0.0, reps });
+	ns = Measure(nullptr, [&]() { pms_util::ComputeGradient(&gray_left[0], width, height, &grad_left[0]); }, min_ms, reps);
+	results.push_back({ "compute_gradient", 0, "", ns / num_pixels, 0.0, reps });
+
+	// شۼۺϴ
+	for (const sint32 patch_size : { 11, 21, 35 }) {
+		PMSOption option;
+		option.patch_size = patch_size;
+		PlanarImage planar_left, planar_right;
+		const sint32 pad = patch_size / 2;
+		planar_left.Create(width, height, pad);
+		planar_right.Create(width, height, pad);
+		planar_left.Fill(&img_left[0], &grad_left[0], 1);
+		planar_right.Fill(&img_right[0], &grad_right[0], 1);
+		CostComputerPMS cost_cpt(&img_left[0], &img_right[0], &grad_left[0], &grad_right[0], width, height, patch_size,
+			min_disp, max_disp, option.gamma, option.alpha, option.tau_col, option.tau_grad);
+		cost_cpt.SetSimdLevel(simd_level);
+		cost_cpt.SetPlanarImages(&planar_left, &planar_right);
+
+		if (patch_size == 11) {
+			float32 sum = 0.0f;
+			ns = Measure(nullptr, [&]() {
+				for (sint32 y = 0; y < height; y++) {
+					for (sint32 x = 0; x < width; x++) {
+						sum += cost_cpt.Compute(x, y, SyntheticDisparity(x, width));
+					}
+				}
+			}, min_ms, reps);
+			results.push_back({ "cost_compute", 0, "", ns / num_pixels, num_pixels / (ns * 1e-9), reps });
+			if (sum < 0.0f) {
+				printf("%f\n", sum);
+			}
+		}
+		for (const bool is_slanted : { false, true }) {
+			switch (patch_size) {
+			case 11:
+				results.push_back(BenchComputeA<11>(cost_cpt, width, height, is_slanted, min_ms));
+				break;
+			case 21:
+				results.push_back(BenchComputeA<21>(cost_cpt, width, height, is_slanted, min_ms));
+				break;
+			default:
+				results.push_back(BenchComputeA<35>(cost_cpt, width, height, is_slanted, min_ms));
+				break;
+			}
+		}
+	}
+
+	// Ӳƽ棺бƽתӲתһͼ
+	vector<DisparityPlane> planes(num_pixels);
+	vector<float32> disp_left(num_pixels), disp_right(num_pixels);
+	for (sint32 y = 0; y < height; y++) {
+		for (sint32 x = 0; x < width; x++) {
+			PMSRandom rng(1, 0, y * width + x);
+			PVector3f norm(rng.Uniform(-1.0f, 1.0f), rng.Uniform(-1.0f, 1.0f), rng.Uniform(0.1f, 1.0f));
+			norm.normalize();
+			planes[y * width + x] = DisparityPlane(x, y, norm, rng.Uniform(min_disp, max_disp));
+		}
+	}
+	ns = Measure(nullptr, [&]() {
+		for (sint32 y = 0; y < height; y++) {
+			for (sint32 x = 0; x < width; x++) {
+				disp_left[y * width + x] = planes[y * width + x].to_disparity(x, y);
+			}
+		}
+	}, min_ms, reps);
+	results.push_back({ "plane_to_disparity", 0, "", ns / num_pixels, 0.0, reps });
+	vector<DisparityPlane> planes_other(num_pixels);
+	ns = Measure(nullptr, [&]() {
+		for (sint32 y = 0; y < height; y++) {
+			for (sint32 x = 0; x < width; x++) {
+				planes_other[y * width + x] = planes[y * width + x].to_another_view(x, y);
+			}
+		}
+	}, min_ms, reps);
+	results.push_back({ "plane_to_another_view", 0, "", ns / num_pixels, 0.0, reps });
+
+	// һԼ飺ͼΪϳӲŶͼΪӦֵԼ10%زһ
+	for (sint32 y = 0; y < height; y++) {
+		for (sint32 x = 0; x < width; x++) {
+			const sint32 p = y * width + x;
+			disp_left[p] = SyntheticDisparity(x, width) + ((PMSRandom::Mix(p) % 10 == 0) ? 5.0f : 0.0f);
+			const sint32 xl = std::min(x + static_cast<sint32>(lround(SyntheticDisparity(x, width))), width - 1);
+			disp_right[p] = -SyntheticDisparity(xl, width);
+		}
+	}
+	PMSOption option;
+	option.num_threads = 1;
+	option.lrcheck_thres = 1.0f;
+	PMSPostProcessor post;
+	post.Prepare(width, height, option);
+	vector<float32> disp_check(num_pixels);
+	vector<pair<int, int>> mismatches;
+	ns = Measure([&]() { disp_check = disp_left; }, [&]() { post.LRCheck(&disp_check[0], &disp_right[0], mismatches); }, min_ms, reps);
+	results.push_back({ "lr_check", 0, "", ns / num_pixels, 0.0, reps });
+
+	// ֵ˲һԼõؼ˲Ĭϴ35˲ؼƣʱֵؼ
+	// Ȩֵʱƥʱʵ·Ӳ䣨median_filter=01䱾
+	const sint32 wnd_size = option.patch_size;
+	vector<float32> disp_filter(num_pixels);
+	const auto restore = [&]() {
+		disp_filter = disp_check;
+	};
+	option.median_filter = PMS_MEDIAN_WEIGHTED;
+	post.Prepare(width, height, option);
+	ns = Measure(restore, [&]() {
+		post.FillHoles(&img_left[0], &planes[0], mismatches, &disp_filter[0]);
+	}, min_ms, reps);
+	results.push_back({ "weighted_median", wnd_size, "", ns / mismatches.size(), 0.0, reps });
+	option.median_filter = PMS_MEDIAN_WEIGHTED_HIST;
+	post.Prepare(width, height, option);
+	ns = Measure(restore, [&]() {
+		post.FillHoles(&img_left[0], &planes[0], mismatches, &disp_filter[0]);
+	}, min_ms, reps);
+	results.push_back({ "weighted_median_hist", wnd_size, "", ns / mismatches.size(), 0.0, reps });
+	vector<float32> disp_median(num_pixels);
+	ns = Measure(nullptr, [&]() {
+		pms_util::MedianFilterO1(&disp_left[0], &disp_median[0], width, height, wnd_size);
+	}, min_ms, reps);
+	results.push_back({ "median_o1", wnd_size, "", ns / num_pixels, 0.0, reps });
+
+	WriteJson(stdout, width, height, simd_level, results);
+	if (output != nullptr) {
+		FILE* fp = fopen(output, "w");
+		if (fp == nullptr) {
+			fprintf(stderr, "failed to open %s\n", output);
+			return -1;
+		}
+		WriteJson(fp, width, height, simd_level, results);
+		fclose(fp);
+	}
+	return 0;
+}
@@ -0,0 +1,485 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: headless command line tool
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "pms_batch.h"
+#include "pms_util.h"
+
+// opencv libraryֻʹӰдģ
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#ifdef _WIN32
+#ifdef _DEBUG
+#pragma comment(lib,"opencv_world310d.lib")
+#else
+#pragma comment(lib,"opencv_world310.lib")
+#endif
+#endif
+
+/**
+ * ޽йߣLinux±루Makefileƥ
+ * ÷PatchMatchStereoCli [ѡ] left right [output]
+ *       PatchMatchStereoCli [ѡ] -l pairs.txt
+ *   -l	бļÿУleft right [output [min_disparity max_disparity]]#ͷΪע
+ *   -c	ļÿ key=value#ͷΪעͣkeyΪPMSOptionԱгѡ
+ *   -j	ƥĬ1>1ʱͬߴ硢ͬӲΧԲƥ䣨PMSBatchMatcher
+ *   -f	ӲͼʽpfmĬϣӲЧֵΪinfpng16λӲ--png_scaleȡЧӲΪ0
+ *   -q	Եĺʱ
+ *   --png_scale s	pngʽӲűĬ256
+ *   --storage_dir d	ڴӳʱļĿ¼PMSOption::storage_dir
+ *   --key value  --key=value	PMSOptionԱ--patch_size 35 --is_fource_fpw 1
+ * ȼ > ļ > ĬֵmainеĲһ£
+ * outputȱʡʱΪӰ·ȥչ -disp.pfm  -disp.png
+ * Ӱcv::imreadBGRֱӴƥ䣬ؿ
+ */
+
+namespace {
+	/** \brief ƥ */
+	struct PairTask {
+		std::string left;		// Ӱ·
+		std::string right;		// Ӱ·
+		std::string output;		// Ӳͼ·
+		sint32 min_disparity;	// СӲ
+		sint32 max_disparity;	// Ӳ
+	};
+
+	/** \brief Ѷ */
+	struct LoadedPair {
+		const PairTask* task;	// 
+		cv::Mat img_left;		// ӰBGR洢
+		cv::Mat img_right;		// ӰBGR洢
+		vector<float32> disp;	// Ӳͼ
+	};
+
+	/** \brief  */
+	struct CliSettings {
+		PMSOption option;		// 㷨
+		std::string storage_dir;	// ڴӳʱļĿ¼option.storage_dirָ
+		std::string format;		// Ӳͼʽ pfm/png
+		float32 png_scale;		// pngʽӲű
+		sint32 num_workers;		// ƥ
+		bool is_quiet;			// ǷԵĺʱ
+		CliSettings() : format("pfm"), png_scale(256.0f), num_workers(1), is_quiet(false) { }
+	};
+
+	/** \brief ĬϲmainеĲһ */
+	PMSOption DefaultOption()
+	{
+		PMSOption option;
+		option.patch_size = 35;
+		option.min_disparity = 0;
+		option.max_disparity = 64;
+		option.gamma = 10.0f;
+		option.alpha = 0.9f;
+		option.tau_col = 10.0f;
+		option.tau_grad = 2.0f;
+		option.num_iters = 3;
+		option.is_check_lr = true;
+		option.lrcheck_thres = 1.0f;
+		option.is_fill_holes = false;
+		option.is_fource_fpw = false;
+		option.is_integer_disp = false;
+		return option;
+	}
+
+	/** \brief ȥβհ */
+	std::string Trim(const std::string& str)
+	{
+		const auto begin = str.find_first_not_of(" \t\r\n");
+		if (begin == std::string::npos) {
+			return "";
+		}
+		const auto end = str.find_last_not_of(" \t\r\n");
+		return str.substr(begin, end - begin + 1);
+	}
+
+	/**
+	 * \brief һйĲPMSOptionԱ
+	 * \param settings	
+	 * \param key		
+	 * \param value		ֵ
+	 * \return ɹtrue
+	 */
+	bool SetSetting(CliSettings& settings, const std::string& key, const std::string& value)
+	{
+		if (key == "storage_dir") {
+			settings.storage_dir = value;
+			return true;
+		}
+		if (key == "format") {
+			settings.format = value;
+			return value == "pfm" || value == "png";
+		}
+		if (key == "png_scale") {
+			settings.png_scale = static_cast<float32>(atof(value.c_str()));
+			return settings.png_scale > 0.0f;
+		}
+		if (key == "workers") {
+			settings.num_workers = atoi(value.c_str());
+			return settings.num_workers > 0;
+		}
+		return pms_util::SetOption(settings.option, key, value);
+	}
+
+	/**
+	 * \brief ȡļÿ key=value
+	 * \param path		ļ·
+	 * \param settings	
+	 * \return ɹtrue
+	 */
+	bool LoadConfig(const std::string& path, CliSettings& settings)
+	{
+		std::ifstream fs(path);
+		if (!fs) {
+			fprintf(stderr, "޷ȡļ%s\n", path.c_str());
+			return false;
+		}
+		std::string line;
+		while (std::getline(fs, line)) {
+			line = Trim(line);
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			const auto pos = line.find('=');
+			if (pos == std::string::npos || !SetSetting(settings, Trim(line.substr(0, pos)), Trim(line.substr(pos + 1)))) {
+				fprintf(stderr, "%s : Ч %s\n", path.c_str(), line.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** \brief Ӱ·ĬϵӲͼ· */
+	std::string DefaultOutput(const std::string& left, const std::string& format)
+	{
+		const auto dot = left.find_last_of('.');
+		const auto slash = left.find_last_of("/\\");
+		const bool has_ext = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+		return (has_ext ? left.substr(0, dot) : left) + "-disp." + format;
+	}
+
+	/**
+	 * \brief ȡбļÿУleft right [output [min_disparity max_disparity]]
+	 * \param path		ļ·
+	 * \param settings	ãṩĬӲΧʽ
+	 * \param tasks		б
+	 * \return ɹtrue
+	 */
+	bool LoadPairList(const std::string& path, const CliSettings& settings, vector<PairTask>& tasks)
+	{
+		std::ifstream fs(path);
+		if (!fs) {
+			fprintf(stderr, "޷ȡб%s\n", path.c_str());
+			return false;
+		}
+		std::string line;
+		sint32 line_no = 0;
+		while (std::getline(fs, line)) {
+			line_no++;
+			line = Trim(line);
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			std::istringstream ss(line);
+			vector<std::string> items;
+			std::string item;
+			while (ss >> item) {
+				items.push_back(item);
+			}
+			if (items.size() != 2 && items.size() != 3 && items.size() != 5) {
+				fprintf(stderr, "%s:%d : ʽӦΪ left right [output [min_disparity max_disparity]]\n", path.c_str(), line_no);
+				return false;
+			}
+			PairTask task;
+			task.left = items[0];
+			task.right = items[1];
+			task.output = items.size() > 2 ? items[2] : DefaultOutput(task.left, settings.format);
+			task.min_disparity = items.size() == 5 ? atoi(items[3].c_str()) : settings.option.min_disparity;
+			task.max_disparity = items.size() == 5 ? atoi(items[4].c_str()) : settings.option.max_disparity;
+			tasks.push_back(task);
+		}
+		return true;
+	}
+
+	/**
+	 * \brief ȡɫӰimreadĽΪ洢BGRݣֱΪƥ
+	 * \param path		Ӱ·
+	 * \param img		Ӱ
+	 * \return ɹtrue
+	 */
+	bool LoadImage(const std::string& path, cv::Mat& img)
+	{
+		img = cv::imread(path, cv::IMREAD_COLOR);
+		if (img.data == nullptr) {
+			fprintf(stderr, "ȡӰ%sʧܣ\n", path.c_str());
+			return false;
+		}
+		if (!img.isContinuous()) {
+			img = img.clone();
+		}
+		return true;
+	}
+
+	/**
+	 * \brief PFMʽӲͼСˣ¶ϣЧֵΪinf
+	 * \param path		ļ·
+	 * \param disp		Ӳͼ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \return ɹtrue
+	 */
+	bool SavePfm(const std::string& path, const float32* disp, const sint32& width, const sint32& height)
+	{
+		FILE* fp = fopen(path.c_str(), "wb");
+		if (fp == nullptr) {
+			return false;
+		}
+		bool ok = fprintf(fp, "Pf\n%d %d\n-1.0\n", width, height) > 0;
+		for (sint32 i = height - 1; i >= 0 && ok; i--) {
+			ok = fwrite(disp + static_cast<size_t>(i) * width, sizeof(float32), width, fp) == static_cast<size_t>(width);
+		}
+		return fclose(fp) == 0 && ok;
+	}
+
+	/**
+	 * \brief 16λPNGʽӲͼӲscaleȡЧӲΪ0
+	 * \param path		ļ·
+	 * \param disp		Ӳͼ
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param scale		Ӳű
+	 * \return ɹtrue
+	 */
+	bool SavePng16(const std::string& path, const float32* disp, const sint32& width, const sint32& height, const float32& scale)
+	{
+		cv::Mat mat(height, width, CV_16UC1);
+		for (sint32 i = 0; i < height; i++) {
+			uint16* row = mat.ptr<uint16>(i);
+			for (sint32 j = 0; j < width; j++) {
+				const float32 d = disp[i * width + j];
+				row[j] = (d == Invalid_Float || d <= 0.0f) ? 0 : static_cast<uint16>(std::min(d * scale + 0.5f, 65535.0f));
+			}
+		}
+		return cv::imwrite(path, mat);
+	}
+
+	/**
+	 * \brief ƥһͬߴ硢ͬӲΧԲ
+	 * \param matcher	ƥ
+	 * \param settings	
+	 * \param group		
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param is_reset	ǷҪµĳߴӲΧƥ
+	 * \return ƥʧܵ
+	 */
+	sint32 MatchGroup(PMSBatchMatcher& matcher, const CliSettings& settings, vector<LoadedPair>& group,
+		const sint32& width, const sint32& height, const bool& is_reset)
+	{
+		if (group.empty()) {
+			return 0;
+		}
+		PMSOption option = settings.option;
+		option.min_disparity = group[0].task->min_disparity;
+		option.max_disparity = group[0].task->max_disparity;
+		if (is_reset && !matcher.Reset(width, height, option)) {
+			fprintf(stderr, "PMSʼʧܣ\n");
+			return static_cast<sint32>(group.size());
+		}
+
+		vector<PMSPair> pairs;
+		for (auto& pair : group) {
+			pair.disp.resize(static_cast<size_t>(width) * height);
+			pairs.emplace_back(pair.img_left.data, pair.img_right.data, &pair.disp[0]);
+		}
+		vector<bool> results;
+		const pms_util::Timer timer;
+		matcher.Match(pairs, &results);
+		const float64 ms = timer.Elapsed();
+
+		sint32 num_failed = 0;
+		for (size_t k = 0; k < group.size(); k++) {
+			const auto& pair = group[k];
+			bool ok = results[k];
+			if (ok) {
+				ok = settings.format == "png" ? SavePng16(pair.task->output, &pair.disp[0], width, height, settings.png_scale)
+					: SavePfm(pair.task->output, &pair.disp[0], width, height);
+				if (!ok) {
+					fprintf(stderr, "Ӳͼ%sʧܣ\n", pair.task->output.c_str());
+				}
+			}
+			else {
+				fprintf(stderr, "PMSƥʧܣ%s %s\n", pair.task->left.c_str(), pair.task->right.c_str());
+			}
+			num_failed += ok ? 0 : 1;
+			if (!settings.is_quiet) {
+				printf("%s %s -> %s : %s, %dx%d, %.1lf ms\n", pair.task->left.c_str(), pair.task->right.c_str(), pair.task->output.c_str(),
+					ok ? "ok" : "failed", width, height, ms / group.size());
+			}
+		}
+		fflush(stdout);
+		group.clear();
+		return num_failed;
+	}
+
+	void PrintUsage()
+	{
+		printf("usage: PatchMatchStereoCli [options] left right [output]\n"
+			"       PatchMatchStereoCli [options] -l pairs.txt\n"
+			"  -l file        pair list, one pair per line: left right [output [min_disparity max_disparity]]\n"
+			"  -c file        config file, one key=value per line\n"
+			"  -j n           number of pairs matched concurrently (default 1)\n"
+			"  -f pfm|png     disparity format (default pfm; png is 16-bit, scaled by --png_scale)\n"
+			"  -q             quiet\n"
+			"  --png_scale s  disparity scale of png output (default 256)\n"
+			"  --storage_dir d  directory of memory-mapped storage\n"
+			"  --<key> value  any PMSOption member, e.g. --patch_size 35 --is_fource_fpw 1\n");
+	}
+}
+
+int main(int argv, char** argc)
+{
+	// ȶȡļв󸲸
+	CliSettings settings;
+	settings.option = DefaultOption();
+	for (sint32 i = 1; i + 1 < argv; i++) {
+		if (std::string(argc[i]) == "-c" && !LoadConfig(argc[i + 1], settings)) {
+			return -1;
+		}
+	}
+
+	std::string list_path;
+	vector<std::string> positional;
+	for (sint32 i = 1; i < argv; i++) {
+		const std::string arg = argc[i];
+		if (arg == "-h" || arg == "--help") {
+			PrintUsage();
+			return 0;
+		}
+		if (arg == "-q") {
+			settings.is_quiet = true;
+			continue;
+		}
+		if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+			// --key=value  --key value
+			std::string key = arg.substr(2), value;
+			const auto pos = key.find('=');
+			if (pos != std::string::npos) {
+				value = key.substr(pos + 1);
+				key = key.substr(0, pos);
+			}
+			else if (i + 1 < argv) {
+				value = argc[++i];
+			}
+			if (!SetSetting(settings, key, value)) {
+				fprintf(stderr, "Ч --%s %s\n", key.c_str(), value.c_str());
+				return -1;
+			}
+			continue;
+		}
+		if (arg == "-c" || arg == "-l" || arg == "-j" || arg == "-f") {
+			if (i + 1 >= argv) {
+				fprintf(stderr, "%s ȱٲֵ\n", arg.c_str());
+				return -1;
+			}
+			const std::string value = argc[++i];
+			if ((arg == "-j" && !SetSetting(settings, "workers", value)) || (arg == "-f" && !SetSetting(settings, "format", value))) {
+				fprintf(stderr, "Ч %s %s\n", arg.c_str(), value.c_str());
+				return -1;
+			}
+			if (arg == "-l") {
+				list_path = value;
+			}
+			continue;
+		}
+		positional.push_back(arg);
+	}
+	settings.option.storage_dir = settings.storage_dir.empty() ? nullptr : settings.storage_dir.c_str();
+
+	// б
+	vector<PairTask> tasks;
+	if (!list_path.empty()) {
+		if (!positional.empty()) {
+			fprintf(stderr, "-l Բͬʱָ\n");
+			return -1;
+		}
+		if (!LoadPairList(list_path, settings, tasks)) {
+			return -1;
+		}
+	}
+	else if (positional.size() == 2 || positional.size() == 3) {
+		PairTask task;
+		task.left = positional[0];
+		task.right = positional[1];
+		task.output = positional.size() == 3 ? positional[2] : DefaultOutput(task.left, settings.format);
+		task.min_disparity = settings.option.min_disparity;
+		task.max_disparity = settings.option.max_disparity;
+		tasks.push_back(task);
+	}
+	else {
+		PrintUsage();
+		return -1;
+	}
+
+	// ԣߴ缰ӲΧͬԴһ󲢷ƥ䣬仯ʱƥߴ粻ʱڴ棩
+	PMSBatchMatcher matcher;
+	bool is_initialized = false, is_reset = false;
+	sint32 width = 0, height = 0, min_disparity = 0, max_disparity = 0;
+	vector<LoadedPair> group;
+	sint32 num_failed = 0;
+	const pms_util::Timer timer;
+	for (const auto& task : tasks) {
+		LoadedPair pair;
+		pair.task = &task;
+		if (!LoadImage(task.left, pair.img_left) || !LoadImage(task.right, pair.img_right)) {
+			num_failed++;
+			continue;
+		}
+		if (pair.img_left.size() != pair.img_right.size()) {
+			fprintf(stderr, "Ӱߴ粻һ£%s %s\n", task.left.c_str(), task.right.c_str());
+			num_failed++;
+			continue;
+		}
+		const sint32 w = pair.img_left.cols, h = pair.img_left.rows;
+		const bool is_same = w == width && h == height && task.min_disparity == min_disparity && task.max_disparity == max_disparity;
+		if (!is_same || static_cast<sint32>(group.size()) >= settings.num_workers) {
+			num_failed += MatchGroup(matcher, settings, group, width, height, is_reset);
+			is_reset = false;
+		}
+		if (!is_same) {
+			width = w;
+			height = h;
+			min_disparity = task.min_disparity;
+			max_disparity = task.max_disparity;
+			if (!is_initialized) {
+				PMSOption option = settings.option;
+				option.min_disparity = min_disparity;
+				option.max_disparity = max_disparity;
+				if (!matcher.Initialize(width, height, option, settings.num_workers)) {
+					fprintf(stderr, "PMSʼʧܣ\n");
+					return -2;
+				}
+				is_initialized = true;
+			}
+			else {
+				is_reset = true;
+			}
+		}
+		group.push_back(std::move(pair));
+	}
+	num_failed += MatchGroup(matcher, settings, group, width, height, is_reset);
+
+	if (!settings.is_quiet) {
+		printf("%d pairs, %d failed, %.1lf s\n", static_cast<sint32>(tasks.size()), num_failed, timer.Elapsed() / 1000.0);
+	}
+	return num_failed == 0 ? 0 : -2;
+}
@@ -0,0 +1,672 @@
+/* -*-c++-*- PatchMatchStereo - Copyright (C) 2020.
+* Author	: Yingsong Li(Ethan Li) <ethan.li.whu@gmail.com>
+*			  https://github.com/ethan-li-coding
+* Describe	: accuracy-vs-time runner
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include "PatchMatchStereo.h"
+#include "pms_util.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib,"psapi.lib")
+#endif
+
+// opencv library
+#include <opencv2/opencv.hpp>
+#ifdef _WIN32
+#ifdef _DEBUG
+#pragma comment(lib,"opencv_world310d.lib")
+#else
+#pragma comment(lib,"opencv_world310.lib")
+#endif
+#endif
+
+/**
+ * ˵˾-ʱԣԸݼһãͳƥʱڴֵƥʣٶ-ȵPareto
+ * ÷PatchMatchStereoRunner [-c configs.txt] [-o results.csv] [-r repeats] [-t threads] [-e thres] [dataset_dir ...]
+ *   -c	ļÿһã key=value key=value ...keyΪPMSOptionԱ#ͷΪעͣȱʡʱʹü
+ *   -o	CSVļ
+ *   -r	ÿõظʱȡֵĬ1
+ *   -t	߳Ĭ0Ӳ߳
+ *   -e	Paretoʹõֵأȡ12Ĭ1
+ *   dataset_dir	ݼĿ¼ȱʡʱΪ..\Data\Cone ..\Data\Piano ..\Data\Reindeer
+ *
+ * ݼĿ¼µd_range.txtΪkey=valueʽ
+ *   dmin/dmax	ӲΧ裩
+ *   left/right	Ӱļȱʡʱγim0/im1im2/im6view1/view5.png
+ *   gt			ͼֵӲļȱʡʱγdisp0GT.pfmdisp0.pfmdisp2.pngdisp1.pngʱ׸õĽΪο
+ *   gt_scale	PNGֵӲűȱʡʱȡround(255/dmax)Middlebury 2003/2005ݵԼPFMֵΪʵӲ
+ *
+ * þmainеĲΪһԼ鼰Ӳ䣬ӹ̶ɸ
+ * ֻͳֵЧأƥӲЧؼΪƥ
+ */
+
+namespace {
+	/** \brief ݼ */
+	struct Dataset {
+		std::string name;		// ƣĿ¼
+		sint32 width, height;	// Ӱ
+		sint32 min_disparity;	// СӲ
+		sint32 max_disparity;	// Ӳ
+		vector<uint8> left;		// ӰBGR
+		vector<uint8> right;	// ӰBGR
+		vector<float32> gt;		// ͼֵӲЧΪInvalid_FloatֵʱΪ
+	};
+
+	/** \brief  */
+	struct RunConfig {
+		std::string name;		// 
+		std::string desc;		// key=valueб
+		PMSOption option;		// 㷨ӲΧ߳ʱã
+	};
+
+	/** \brief н */
+	struct RunResult {
+		std::string dataset;	// ݼ
+		std::string config;		// 
+		float64 time_ms;		// ƥʱ룬ظȡ̣
+		float64 peak_rss_mb;	// ƥ̵ڴֵMB޷ȡʱΪ0
+		float64 est_mem_mb;		// ԤڴռãMBPatchMatchStereo::EstimateMemory
+		float64 bad1;			// 1صر%
+		float64 bad2;			// 2صر%
+		float64 avg_err;		// ЧӲƽأ
+		float64 invalid;		// ЧӲر%
+		bool is_ref;			// ǷԲοõĽֵ
+		bool is_pareto;			// ǷParetoǰ
+	};
+
+	/** \brief ȥβհ */
+	std::string Trim(const std::string& str)
+	{
+		const auto begin = str.find_first_not_of(" \t\r\n");
+		if (begin == std::string::npos) {
+			return "";
+		}
+		const auto end = str.find_last_not_of(" \t\r\n");
+		return str.substr(begin, end - begin + 1);
+	}
+
+	/** \brief жļǷ */
+	bool FileExists(const std::string& path)
+	{
+		std::ifstream fs(path);
+		return fs.good();
+	}
+
+	/** \brief ȡ·һ */
+	std::string BaseName(std::string path)
+	{
+		while (!path.empty() && (path.back() == '/' || path.back() == '\\')) {
+			path.pop_back();
+		}
+		const auto pos = path.find_last_of("/\\");
+		return pos == std::string::npos ? path : path.substr(pos + 1);
+	}
+
+	/**
+	 * \brief ȡɫӰ
+	 * \param path		Ӱ·
+	 * \param width		Ӱ
+	 * \param height		Ӱ
+	 * \param bytes		ɫݣBGR
+	 * \return ɹtrue
+	 */
+	bool LoadColorImage(const std::string& path, sint32& width, sint32& height, vector<uint8>& bytes)
+	{
+		const cv::Mat img = cv::imread(path, cv::IMREAD_COLOR);
+		if (img.data == nullptr) {
+			return false;
+		}
+		width = img.cols;
+		height = img.rows;
+		bytes.resize(static_cast<size_t>(width) * height * 3);
+		for (sint32 i = 0; i < height; i++) {
+			memcpy(&bytes[static_cast<size_t>(i) * width * 3], img.ptr<uint8>(i), width * 3);
+		}
+		return true;
+	}
+
+	/**
+	 * \brief ȡPFMʽĵͨӲͼ¶ϣscaleΪʾС˴洢ΪЧֵ
+	 * \param path		ļ·
+	 * \param width		Ӱļһ
+	 * \param height		Ӱߣļһ
+	 * \param disp		Ӳͼ϶£
+	 * \return ɹtrue
+	 */
+	bool LoadPfm(const std::string& path, const sint32& width, const sint32& height, vector<float32>& disp)
+	{
+		std::ifstream fs(path, std::ios::binary);
+		std::string type;
+		sint32 w = 0, h = 0;
+		float64 scale = 0.0;
+		fs >> type >> w >> h >> scale;
+		fs.get();
+		if (!fs || type != "Pf" || w != width || h != height) {
+			return false;
+		}
+		disp.resize(static_cast<size_t>(width) * height);
+		for (sint32 i = height - 1; i >= 0; i--) {
+			fs.read(reinterpret_cast<char*>(&disp[static_cast<size_t>(i) * width]), width * sizeof(float32));
+		}
+		if (!fs) {
+			return false;
+		}
+		if (scale > 0.0) {
+			// ˴洢ֽ
+			for (auto& d : disp) {
+				auto* b = reinterpret_cast<uint8*>(&d);
+				std::swap(b[0], b[3]);
+				std::swap(b[1], b[2]);
+			}
+		}
+		for (auto& d : disp) {
+			if (!std::isfinite(d)) {
+				d = Invalid_Float;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * \brief ȡ8λPNGֵӲͼ0ΪЧֵ
+	 * \param path		ļ·
+	 * \param width		Ӱļһ
+	 * \param height		Ӱߣļһ
+	 * \param scale		Ӳű
+	 * \param disp		Ӳͼ
+	 * \return ɹtrue
+	 */
+	bool LoadPngDisparity(const std::string& path, const sint32& width, const sint32& height, const float32& scale, vector<float32>& disp)
+	{
+		const cv::Mat img = cv::imread(path, cv::IMREAD_GRAYSCALE);
+		if (img.data == nullptr || img.cols != width || img.rows != height) {
+			return false;
+		}
+		disp.resize(static_cast<size_t>(width) * height);
+		for (sint32 i = 0; i < height; i++) {
+			const uint8* row = img.ptr<uint8>(i);
+			for (sint32 j = 0; j < width; j++) {
+				disp[i * width + j] = row[j] == 0 ? Invalid_Float : row[j] / scale;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * \brief ȡݼ
+	 * \param dir		ݼĿ¼
+	 * \param data		ݼ
+	 * \return ɹtrue
+	 */
+	bool LoadDataset(const std::string& dir, Dataset& data)
+	{
+		data.name = BaseName(dir);
+
+		// ȡd_range.txtеkey=value
+		std::ifstream fs(dir + "/d_range.txt");
+		if (!fs) {
+			printf("%s : ޷ȡd_range.txt\n", data.name.c_str());
+			return false;
+		}
+		std::string dmin, dmax, left, right, gt, gt_scale, line;
+		while (std::getline(fs, line)) {
+			const auto pos = line.find('=');
+			if (pos == std::string::npos) {
+				continue;
+			}
+			const std::string key = Trim(line.substr(0, pos)), value = Trim(line.substr(pos + 1));
+			if (key == "dmin") dmin = value;
+			else if (key == "dmax") dmax = value;
+			else if (key == "left") left = value;
+			else if (key == "right") right = value;
+			else if (key == "gt") gt = value;
+			else if (key == "gt_scale") gt_scale = value;
+		}
+		if (dmin.empty() || dmax.empty()) {
+			printf("%s : d_range.txtȱdmindmax\n", data.name.c_str());
+			return false;
+		}
+		data.min_disparity = atoi(dmin.c_str());
+		data.max_disparity = atoi(dmax.c_str());
+
+		// Ӱ
+		if (left.empty() || right.empty()) {
+			const char* pairs[][2] = { { "im0.png", "im1.png" }, { "im2.png", "im6.png" }, { "view1.png", "view5.png" } };
+			for (const auto& pair : pairs) {
+				if (FileExists(dir + "/" + pair[0]) && FileExists(dir + "/" + pair[1])) {
+					left = pair[0];
+					right = pair[1];
+					break;
+				}
+			}
+		}
+		sint32 w_right = 0, h_right = 0;
+		if (left.empty() || !LoadColorImage(dir + "/" + left, data.width, data.height, data.left) ||
+			!LoadColorImage(dir + "/" + right, w_right, h_right, data.right)) {
+			printf("%s : ȡӰʧܣ\n", data.name.c_str());
+			return false;
+		}
+		if (w_right != data.width || h_right != data.height) {
+			printf("%s : Ӱߴ粻һ£\n", data.name.c_str());
+			return false;
+		}
+
+		// ֵѡ
+		data.gt.clear();
+		if (gt.empty()) {
+			for (const char* name : { "disp0GT.pfm", "disp0.pfm", "disp2.png", "disp1.png" }) {
+				if (FileExists(dir + "/" + name)) {
+					gt = name;
+					break;
+				}
+			}
+		}
+		if (!gt.empty()) {
+			bool ok;
+			if (gt.size() > 4 && gt.compare(gt.size() - 4, 4, ".pfm") == 0) {
+				ok = LoadPfm(dir + "/" + gt, data.width, data.height, data.gt);
+			}
+			else {
+				const float32 scale = gt_scale.empty() ? std::max(1.0f, std::round(255.0f / std::max(data.max_disparity, 1))) : static_cast<float32>(atof(gt_scale.c_str()));
+				ok = LoadPngDisparity(dir + "/" + gt, data.width, data.height, scale, data.gt);
+			}
+			if (!ok) {
+				printf("%s : ȡֵ%sʧܣԲοõĽ\n", data.name.c_str(), gt.c_str());
+				data.gt.clear();
+			}
+		}
+		return true;
+	}
+
+	/** \brief mainеĲһ£һԼ鼰Ӳ */
+	PMSOption BaseOption()
+	{
+		PMSOption option;
+		option.patch_size = 35;
+		option.gamma = 10.0f;
+		option.alpha = 0.9f;
+		option.tau_col = 10.0f;
+		option.tau_grad = 2.0f;
+		option.num_iters = 3;
+		option.is_check_lr = true;
+		option.lrcheck_thres = 1.0f;
+		option.is_fill_holes = true;
+		option.seed = 1;
+		return option;
+	}
+
+	/**
+	 * \brief һã key=value key=value ...
+	 * \param line		
+	 * \param config	
+	 * \return ɹtrue
+	 */
+	bool ParseConfig(const std::string& line, RunConfig& config)
+	{
+		std::istringstream ss(line);
+		if (!(ss >> config.name)) {
+			return false;
+		}
+		config.option = BaseOption();
+		config.desc.clear();
+		std::string item;
+		while (ss >> item) {
+			const auto pos = item.find('=');
+			if (pos == std::string::npos || !pms_util::SetOption(config.option, item.substr(0, pos), item.substr(pos + 1))) {
+				printf("%s : Ч%s\n", config.name.c_str(), item.c_str());
+				return false;
+			}
+			config.desc += (config.desc.empty() ? "" : " ") + item;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief üüģʽĵ仯Ϊּģʽ
+	 * ׸ΪοãֵʱΪõĲο
+	 */
+	vector<std::string> DefaultConfigs()
+	{
+		return {
+			"baseline",
+			"iters2 num_iters=2",
+			"converge num_iters=5 converge_thres=0.01",
+			"patch21 patch_size=21",
+			"patch11 patch_size=11",
+			"fpw is_fource_fpw=1",
+			"integer is_integer_disp=1",
+			"redblack is_redblack_propagation=1",
+			"active is_active_set=1",
+			"fixed is_fixed_point=1",
+			"subpixel4 subpixel_factor=4",
+			"step2 sample_step=2",
+			"pyramid2 pyramid_levels=2",
+			"median_hist median_filter=1",
+			"fast patch_size=21 sample_step=2 is_active_set=1 is_fixed_point=1 pyramid_levels=2 median_filter=1"
+		};
+	}
+
+	/** \brief ý̵ڴֵ֧ʱfalse */
+	bool ResetPeakRss()
+	{
+#ifdef __linux__
+		FILE* fp = fopen("/proc/self/clear_refs", "w");
+		if (fp == nullptr) {
+			return false;
+		}
+		const bool ok = fputs("5", fp) >= 0;
+		return fclose(fp) == 0 && ok;
+#else
+		return false;
+#endif
+	}
+
+	/** \brief ȡ̵ڴֵMB޷ȡʱ0 */
+	float64 PeakRssMb()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS pmc;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+			return pmc.PeakWorkingSetSize / (1024.0 * 1024.0);
+		}
+#elif defined(__linux__)
+		std::ifstream fs("/proc/self/status");
+		std::string line;
+		while (std::getline(fs, line)) {
+			if (line.compare(0, 6, "VmHWM:") == 0) {
+				return atof(line.c_str() + 6) / 1024.0;
+			}
+		}
+#endif
+		return 0.0;
+	}
+
+	/**
+	 * \brief ͳӲͼԲοӲͼ
+	 * \param disp		Ӳͼ
+	 * \param ref		οӲͼЧΪInvalid_Float
+	 * \param size		
+	 * \param result	ͳ
+	 */
+	void Evaluate(const float32* disp, const float32* ref, const sint32& size, RunResult& result)
+	{
+		sint64 num_eval = 0, num_bad1 = 0, num_bad2 = 0, num_invalid = 0, num_valid = 0;
+		float64 sum_err = 0.0;
+		for (sint32 i = 0; i < size; i++) {
+			if (ref[i] == Invalid_Float) {
+				continue;
+			}
+			num_eval++;
+			if (disp[i] == Invalid_Float) {
+				num_invalid++;
+				num_bad1++;
+				num_bad2++;
+				continue;
+			}
+			const float32 err = std::abs(disp[i] - ref[i]);
+			num_bad1 += err > 1.0f;
+			num_bad2 += err > 2.0f;
+			sum_err += err;
+			num_valid++;
+		}
+		const float64 denom = std::max<sint64>(num_eval, 1);
+		result.bad1 = 100.0 * num_bad1 / denom;
+		result.bad2 = 100.0 * num_bad2 / denom;
+		result.invalid = 100.0 * num_invalid / denom;
+		result.avg_err = num_valid > 0 ? sum_err / num_valid : 0.0;
+	}
+
+	/**
+	 * \brief ParetoǰأںʱһС
+	 * \param results	
+	 * \param thres		ֵ1ȡbad1ȡbad2
+	 */
+	void MarkPareto(vector<RunResult*>& results, const sint32& thres)
+	{
+		const auto error = [&](const RunResult* r) { return thres == 1 ? r->bad1 : r->bad2; };
+		for (auto* r : results) {
+			r->is_pareto = true;
+			for (const auto* o : results) {
+				if (o != r && o->time_ms <= r->time_ms && error(o) <= error(r) && (o->time_ms < r->time_ms || error(o) < error(r))) {
+					r->is_pareto = false;
+					break;
+				}
+			}
+		}
+	}
+
+	/** \brief ʱ*Paretoǰ */
+	void PrintTable(const std::string& title, vector<RunResult*> results)
+	{
+		std::sort(results.begin(), results.end(), [](const RunResult* a, const RunResult* b) { return a->time_ms < b->time_ms; });
+		printf("\n== %s ==\n", title.c_str());
+		printf("  %-14s %10s %9s %9s %7s %7s %8s %8s\n", "config", "time(ms)", "rss(MB)", "est(MB)", "bad1%", "bad2%", "avgerr", "invalid%");
+		for (const auto* r : results) {
+			printf("%c %-14s %10.1lf %9.1lf %9.1lf %7.2lf %7.2lf %8.3lf %8.2lf%s\n", r->is_pareto ? '*' : ' ', r->config.c_str(), r->time_ms,
+				r->peak_rss_mb, r->est_mem_mb, r->bad1, r->bad2, r->avg_err, r->invalid, r->is_ref ? "  (ref)" : "");
+		}
+	}
+}
+
+int main(int argv, char** argc)
+{
+	std::string config_path, csv_path;
+	sint32 repeats = 1, num_threads = 0, thres = 1;
+	vector<std::string> dirs;
+	for (sint32 i = 1; i < argv; i++) {
+		const std::string arg = argc[i];
+		if ((arg == "-c" || arg == "-o" || arg == "-r" || arg == "-t" || arg == "-e") && i + 1 < argv) {
+			const std::string value = argc[++i];
+			if (arg == "-c") config_path = value;
+			else if (arg == "-o") csv_path = value;
+			else if (arg == "-r") repeats = std::max(1, atoi(value.c_str()));
+			else if (arg == "-t") num_threads = atoi(value.c_str());
+			else thres = atoi(value.c_str()) == 2 ? 2 : 1;
+		}
+		else {
+			dirs.push_back(arg);
+		}
+	}
+	if (dirs.empty()) {
+		dirs = { "../Data/Cone", "../Data/Piano", "../Data/Reindeer" };
+	}
+
+	// 
+	vector<std::string> lines;
+	if (config_path.empty()) {
+		lines = DefaultConfigs();
+	}
+	else {
+		std::ifstream fs(config_path);
+		if (!fs) {
+			printf("޷ȡļ%s\n", config_path.c_str());
+			return -1;
+		}
+		std::string line;
+		while (std::getline(fs, line)) {
+			line = Trim(line);
+			if (!line.empty() && line[0] != '#') {
+				lines.push_back(line);
+			}
+		}
+	}
+	vector<RunConfig> configs;
+	for (const auto& line : lines) {
+		RunConfig config;
+		if (!ParseConfig(line, config)) {
+			return -1;
+		}
+		configs.push_back(config);
+	}
+	if (configs.empty()) {
+		printf("ûвã\n");
+		return -1;
+	}
+	const bool is_rss_reset = ResetPeakRss();
+	if (!is_rss_reset) {
+		printf("޷ڴֵrssΪķֵ\n");
+	}
+
+	// ݼ
+	vector<RunResult> results;
+	results.reserve(dirs.size() * configs.size());
+	vector<float32> disp_ref;
+	for (const auto& dir : dirs) {
+		Dataset data;
+		if (!LoadDataset(dir, data)) {
+			continue;
+		}
+		const sint32 size = data.width * data.height;
+		printf("%s : %dx%d, disparity [%d,%d], %s\n", data.name.c_str(), data.width, data.height, data.min_disparity, data.max_disparity,
+			data.gt.empty() ? "no ground truth" : "ground truth");
+
+		for (size_t k = 0; k < configs.size(); k++) {
+			PMSOption option = configs[k].option;
+			option.min_disparity = data.min_disparity;
+			option.max_disparity = data.max_disparity;
+			option.num_threads = num_threads;
+
+			RunResult result = {};
+			result.dataset = data.name;
+			result.config = configs[k].name;
+			result.est_mem_mb = PatchMatchStereo::EstimateMemory(data.width, data.height, option) / (1024.0 * 1024.0);
+			result.time_ms = std::numeric_limits<float64>::max();
+
+			vector<float32> disp(size);
+			{
+				// ÿʹµʵڴֵֻõķ
+				ResetPeakRss();
+				PatchMatchStereo pms;
+				if (!pms.Initialize(data.width, data.height, option)) {
+					printf("  %s : ʼʧܣ\n", configs[k].name.c_str());
+					continue;
+				}
+				bool ok = true;
+				for (sint32 r = 0; r < repeats && ok; r++) {
+					const pms_util::Timer timer;
+					ok = pms.Match(&data.left[0], &data.right[0], &disp[0]);
+					result.time_ms = std::min(result.time_ms, timer.Elapsed());
+				}
+				if (!ok) {
+					printf("  %s : ƥʧܣ\n", configs[k].name.c_str());
+					continue;
+				}
+				result.peak_rss_mb = PeakRssMb();
+			}
+
+			// ֵʱֵȽϣοã׸ãĽȽ
+			if (!data.gt.empty()) {
+				Evaluate(&disp[0], &data.gt[0], size, result);
+			}
+			else {
+				if (k == 0) {
+					disp_ref = disp;
+				}
+				if (disp_ref.size() == disp.size()) {
+					Evaluate(&disp[0], &disp_ref[0], size, result);
+				}
+				result.is_ref = true;
+			}
+			printf("  %-14s %10.1lf ms  bad1 %6.2lf%%  bad2 %6.2lf%%  %s\n", result.config.c_str(), result.time_ms, result.bad1, result.bad2,
+				configs[k].desc.c_str());
+			fflush(stdout);
+			results.push_back(result);
+		}
+		disp_ref.clear();
+	}
+	if (results.empty()) {
+		return -1;
+	}
+
+	// ݼPareto
+	vector<std::string> names;
+	for (const auto& r : results) {
+		if (std::find(names.begin(), names.end(), r.dataset) == names.end()) {
+			names.push_back(r.dataset);
+		}
+	}
+	for (const auto& name : names) {
+		vector<RunResult*> subset;
+		for (auto& r : results) {
+			if (r.dataset == name) {
+				subset.push_back(&r);
+			}
+		}
+		MarkPareto(subset, thres);
+		PrintTable(name, subset);
+	}
+
+	// ֻܱȫݼϾгɹãʱͣȡƽڴȡ
+	vector<RunResult> summary;
+	for (const auto& config : configs) {
+		RunResult s = {};
+		s.dataset = "all";
+		s.config = config.name;
+		sint32 count = 0;
+		for (const auto& r : results) {
+			if (r.config == config.name) {
+				s.time_ms += r.time_ms;
+				s.peak_rss_mb = std::max(s.peak_rss_mb, r.peak_rss_mb);
+				s.est_mem_mb = std::max(s.est_mem_mb, r.est_mem_mb);
+				s.bad1 += r.bad1;
+				s.bad2 += r.bad2;
+				s.avg_err += r.avg_err;
+				s.invalid += r.invalid;
+				s.is_ref = s.is_ref || r.is_ref;
+				count++;
+			}
+		}
+		if (count == static_cast<sint32>(names.size())) {
+			s.bad1 /= count;
+			s.bad2 /= count;
+			s.avg_err /= count;
+			s.invalid /= count;
+			summary.push_back(s);
+		}
+	}
+	if (names.size() > 1 && !summary.empty()) {
+		vector<RunResult*> subset;
+		for (auto& s : summary) {
+			subset.push_back(&s);
+		}
+		MarkPareto(subset, thres);
+		PrintTable("all datasets", subset);
+		results.insert(results.end(), summary.begin(), summary.end());
+	}
+	printf("\n* : Pareto front of time vs bad%d\n", thres);
+
+	// CSV
+	if (!csv_path.empty()) {
+		FILE* fp = fopen(csv_path.c_str(), "w");
+		if (fp == nullptr) {
+			printf("޷д%s\n", csv_path.c_str());
+			return -1;
+		}
+		fprintf(fp, "dataset,config,time_ms,peak_rss_mb,est_mem_mb,bad1,bad2,avg_err,invalid,reference,pareto,options\n");
+		for (const auto& r : results) {
+			std::string desc;
+			for (const auto& config : configs) {
+				if (config.name == r.config) {
+					desc = config.desc;
+				}
+			}
+			fprintf(fp, "%s,%s,%.3lf,%.1lf,%.1lf,%.3lf,%.3lf,%.4lf,%.3lf,%s,%d,\"%s\"\n", r.dataset.c_str(), r.config.c_str(), r.time_ms,
+				r.peak_rss_mb, r.est_mem_mb, r.bad1, r.bad2, r.avg_err, r.invalid, r.is_ref ? "config" : "gt", r.is_pareto ? 1 : 0, desc.c_str());
+		}
+		fclose(fp);
+	}
+	return 0;
+}